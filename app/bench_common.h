@@ -0,0 +1,127 @@
+/* bench_common.h – pieces shared by the loopback benchmarks
+ *---------------------------------------------------------------------*
+ *  • The typical robot packet, clocks, sorting and IPOC parsing.       *
+ *  • A simulated robot that sends one packet every cycle to the        *
+ *    library and times the answer to that packet.                      *
+ *  • POSIX only.                                                       *
+ *---------------------------------------------------------------------*/
+
+#ifndef RSI_BENCH_COMMON_H
+#define RSI_BENCH_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define CYCLE_US     4000
+#define IPOC_START   1000u
+
+static const char TYPICAL_FORMAT[] =
+    "<Rob Type=\"KUKA\">\n"
+    "  <RIst X=\"445.0012\" Y=\"-0.0003\" Z=\"790.0000\" A=\"180.0000\" B=\"0.0000\" C=\"-179.9998\"/>\n"
+    "  <RSol X=\"445.0000\" Y=\"0.0000\" Z=\"790.0000\" A=\"-180.0000\" B=\"0.0000\" C=\"-180.0000\"/>\n"
+    "  <AIPos A1=\"-0.0001\" A2=\"-90.0000\" A3=\"90.0000\" A4=\"0.0000\" A5=\"90.0000\" A6=\"0.0000\"/>\n"
+    "  <ASol A1=\"-0.0000\" A2=\"-90.0000\" A3=\"90.0000\" A4=\"0.0000\" A5=\"90.0000\" A6=\"0.0000\"/>\n"
+    "  <Delay D=\"0\"/>\n"
+    "  <IPOC>%u</IPOC>\n"
+    "</Rob>";
+
+static inline double now_us(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static inline int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* IPOC of a NUL-terminated response, 0 if it has none */
+static inline uint32_t response_ipoc(const char* response) {
+    const char* ipoc = strstr(response, "<IPOC>");
+    return ipoc ? (uint32_t)strtoul(ipoc + 6, NULL, 10) : 0;
+}
+
+/*─ Simulated robot ─*/
+typedef struct {
+    uint16_t    port;
+    const char* format;       /* Packet with one %u for the IPOC */
+    int         cycles;
+    double*     rtt_us;       /* One per cycle */
+    int         answered;
+    double      cpu_ms;
+} BenchRobot;
+
+/* Thread body: one packet per cycle, timing only the answer to that packet */
+static inline void* bench_robot_thread(void* arg) {
+    BenchRobot*        robot = arg;
+    struct sockaddr_in addr;
+    struct timespec    next;
+    char               packet[2048];
+    char               response[1024];
+    double             cpu_start = now_us(CLOCK_THREAD_CPUTIME_ID);
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(robot->port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (int i = 0; i < robot->cycles; i++) {
+        next.tv_nsec += CYCLE_US * 1000;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        uint32_t ipoc = IPOC_START + (uint32_t)i * 4u;
+        int len = snprintf(packet, sizeof(packet), robot->format, ipoc);
+        double sent = now_us(CLOCK_MONOTONIC);
+        sendto(sock, packet, (size_t)len, 0, (struct sockaddr*)&addr, sizeof(addr));
+
+        // Only an answer to this packet within the cycle counts; late ones are skipped
+        double deadline = sent + CYCLE_US;
+        for (;;) {
+            double left = deadline - now_us(CLOCK_MONOTONIC);
+            if (left <= 0.0) {
+                break;
+            }
+
+            fd_set readable;
+            struct timespec timeout = { 0, (long)(left * 1e3) };
+            FD_ZERO(&readable);
+            FD_SET(sock, &readable);
+            if (pselect(sock + 1, &readable, NULL, NULL, &timeout, NULL) <= 0) {
+                continue;
+            }
+
+            ssize_t received = recv(sock, response, sizeof(response) - 1, MSG_DONTWAIT);
+            double  now      = now_us(CLOCK_MONOTONIC);
+            if (received <= 0) {
+                continue;
+            }
+            response[received] = '\0';
+            if (response_ipoc(response) == ipoc && now <= deadline) {
+                robot->rtt_us[robot->answered++] = now - sent;
+                break;
+            }
+        }
+    }
+
+    close(sock);
+    robot->cpu_ms = (now_us(CLOCK_THREAD_CPUTIME_ID) - cpu_start) / 1e3;
+    return NULL;
+}
+
+#endif /* RSI_BENCH_COMMON_H */
@@ -108,11 +108,16 @@ int main(void)
     RSI_CartesianCorrection corr;
     zero_correction(&corr);
     RSI_CartesianPosition pos = {0};
+    RSI_Frame frame;
+    uint32_t last_ipoc = 0;
 
     puts("Keyboard jogger ready – press Esc or Ctrl-C to quit.");
 
     while (!g_exit) {
-        if (RSI_GetCartesianPosition(&pos) == RSI_SUCCESS) {
+        // Sleep until the next cycle; the short timeout keeps the keyboard responsive
+        if (RSI_WaitForCycle(last_ipoc, 10, &frame) == RSI_SUCCESS) {
+            pos = frame.cartesian;
+            last_ipoc = frame.ipoc;
             printf("\rIPOC %6u  XYZ %.1f %.1f %.1f mm   ",
                    pos.ipoc, pos.x, pos.y, pos.z);
             fflush(stdout);
@@ -41,12 +41,14 @@ int main(void)
     cfg.local_port = 59152;        // KUKA RSI default port
     cfg.timeout_ms = 1000;         // timeout if no data
     cfg.verbose    = true;         // ENABLE verbose debug output
+    cfg.telemetry_name = "/rsi_monitor"; // watch from another process with rsi_telemetry
 
     printf("Initializing RSI with configuration:\n");
     printf("  Local IP: %s\n", cfg.local_ip);
     printf("  Local Port: %d\n", cfg.local_port);
     printf("  Timeout: %d ms\n", cfg.timeout_ms);
     printf("  Verbose mode: %s\n", cfg.verbose ? "Enabled" : "Disabled");
+    printf("  Telemetry: %s\n", cfg.telemetry_name);
 
     if (RSI_Init(&cfg) != RSI_SUCCESS) {
         fprintf(stderr, "RSI_Init failed\n"); return 1;
@@ -97,42 +99,45 @@ int main(void)
 
     puts("RSI monitor ready …  (Ctrl-C to quit)");
 
-    RSI_CartesianPosition cart = {0};
-    RSI_JointPosition     joint = {0};
-    RSI_Statistics        stats = {0};
-    uint32_t              last_ipoc = 0;
+    RSI_Frame frame = {0};
+    uint32_t  last_ipoc = 0;
 
     while (!g_exit)
     {
-        if (RSI_GetCartesianPosition(&cart) == RSI_SUCCESS &&
-            RSI_GetJointPosition(&joint)   == RSI_SUCCESS &&
-            RSI_GetStatistics(&stats)      == RSI_SUCCESS)
+        // Sleep until the next cycle; positions and stats come from the same cycle
+        if (RSI_WaitForCycle(last_ipoc, 100, &frame) == RSI_SUCCESS)
         {
-            if (cart.ipoc != last_ipoc) {
-                last_ipoc = cart.ipoc;
-
-                printf(
-                    "IPOC %6u | "
-                    "XYZ %.1f %.1f %.1f mm | "
-                    "ABC %.1f %.1f %.1f ° | "
-                    "A %.1f %.1f %.1f %.1f %.1f %.1f ° | "
-                    "pkt_rx %llu  late>4ms %llu\r",
-                    cart.ipoc,
-                    cart.x, cart.y, cart.z,
-                    cart.a, cart.b, cart.c,
-                    joint.axis[0], joint.axis[1], joint.axis[2],
-                    joint.axis[3], joint.axis[4], joint.axis[5],
-                    (unsigned long long)stats.packets_received,
-                    (unsigned long long)stats.late_responses
-                );
-                fflush(stdout);
-            }
+            last_ipoc = frame.ipoc;
+
+            printf(
+                "IPOC %6u | "
+                "XYZ %.1f %.1f %.1f mm | "
+                "ABC %.1f %.1f %.1f ° | "
+                "A %.1f %.1f %.1f %.1f %.1f %.1f ° | "
+                "pkt_rx %llu  late %llu  lost %llu  cycle %.2f ms  jitter max %.3f ms\r",
+                frame.ipoc,
+                frame.cartesian.x, frame.cartesian.y, frame.cartesian.z,
+                frame.cartesian.a, frame.cartesian.b, frame.cartesian.c,
+                frame.joints.axis[0], frame.joints.axis[1], frame.joints.axis[2],
+                frame.joints.axis[3], frame.joints.axis[4], frame.joints.axis[5],
+                (unsigned long long)frame.stats.packets_received,
+                (unsigned long long)frame.stats.late_responses,
+                (unsigned long long)frame.stats.ipoc_missing_cycles,
+                frame.stats.robot_cycle_ms, frame.stats.max_jitter_ms
+            );
+            fflush(stdout);
         }
 
     }
 
     puts("\nStopping …");
     RSI_Stop();
+
+    // Keep the last cycles for offline analysis (decode with rsi_trace)
+    if (RSI_DumpTrace("rsi_monitor.trace") == RSI_SUCCESS) {
+        puts("Trace written to rsi_monitor.trace");
+    }
+
     RSI_Cleanup();
     puts("Done.");
     return 0;
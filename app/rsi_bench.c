@@ -0,0 +1,517 @@
+/* rsi_bench.c – end-to-end loopback latency across deployment settings
+ *---------------------------------------------------------------------*
+ *  • Runs the library against a packet generator on loopback that      *
+ *    sends one packet every 4 ms, once per configuration of a sweep    *
+ *    over five settings. Each option takes a comma-separated list and  *
+ *    every combination is run:                                         *
+ *      -w wait strategy    busy-poll, blocking, epoll, hybrid          *
+ *      -c network CPU      none or a CPU number (default none and the  *
+ *                          last CPU)                                   *
+ *      -r priority         normal, fifo                                *
+ *      -s packet size      small, typical, large (Tech-heavy)          *
+ *      -x background load  none, cpu, memory: one process per CPU      *
+ *                          that spins or streams through 64 MB         *
+ *  • Reports, per configuration, the library's receive-to-send time    *
+ *    (p50 / p99 / p99.9 / max), the kernel-receive-to-send time, the   *
+ *    generator's round trip and the CPU time of the library as a       *
+ *    share of one core, as a table or with -j as JSON.                 *
+ *  • Usage:  rsi_bench [-d seconds per configuration] [-p port] [-j]   *
+ *                      [-w ...] [-c ...] [-r ...] [-s ...] [-x ...]    *
+ *  • POSIX only. fifo and pinning need CAP_SYS_NICE; settings the      *
+ *    system refuses are marked with '!'.                               *
+ *---------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#   include <sys/prctl.h>
+#endif
+
+#include "kuka_rsi.h"
+#include "bench_common.h"
+
+#define MAX_CHOICES   64
+#define MAX_WORKERS   256
+#define STRESS_BYTES  (64u << 20)   /* Per memory worker, well beyond the LLC */
+#define SETTLE_MS     100           /* Let the workers ramp up */
+
+static const char SMALL_FORMAT[] =
+    "<Rob Type=\"KUKA\">"
+    "<RIst X=\"445.0\" Y=\"0.0\" Z=\"790.0\" A=\"180.0\" B=\"0.0\" C=\"-180.0\"/>"
+    "<AIPos A1=\"0.0\" A2=\"-90.0\" A3=\"90.0\" A4=\"0.0\" A5=\"90.0\" A6=\"0.0\"/>"
+    "<IPOC>%u</IPOC>"
+    "</Rob>";
+
+static char g_large_format[2048];
+
+/* The typical packet with six Tech rows and digital outputs */
+static void build_large_format(void) {
+    size_t len = 0;
+    int i, j;
+
+    len += (size_t)snprintf(g_large_format + len, sizeof(g_large_format) - len, "%.*s",
+                            (int)(strstr(TYPICAL_FORMAT, "  <IPOC>") - TYPICAL_FORMAT),
+                            TYPICAL_FORMAT);
+    for (i = 1; i <= 6; i++) {
+        len += (size_t)snprintf(g_large_format + len, sizeof(g_large_format) - len, "  <Tech");
+        for (j = 1; j <= 10; j++) {
+            len += (size_t)snprintf(g_large_format + len, sizeof(g_large_format) - len,
+                                    " C%d%d=\"%.4f\"", i, j, i * 10.0 + j * 0.125);
+        }
+        len += (size_t)snprintf(g_large_format + len, sizeof(g_large_format) - len, "/>\n");
+    }
+    len += (size_t)snprintf(g_large_format + len, sizeof(g_large_format) - len, "  <Digout");
+    for (j = 1; j <= 16; j++) {
+        len += (size_t)snprintf(g_large_format + len, sizeof(g_large_format) - len, " o%d=\"%d\"", j, j & 1);
+    }
+    snprintf(g_large_format + len, sizeof(g_large_format) - len,
+             "/>\n  <DiL>0</DiL>\n  <Source1>8.0</Source1>\n  <IPOC>%%u</IPOC>\n</Rob>");
+}
+
+/*─ Settings ─*/
+typedef struct {
+    const char* name;
+    int         value;
+} Choice;
+
+enum { SIZE_SMALL, SIZE_TYPICAL, SIZE_LARGE };
+enum { STRESS_NONE, STRESS_CPU, STRESS_MEMORY };
+
+static const Choice WAITS[] = {
+    { "busy-poll", RSI_WAIT_BUSY_POLL },
+    { "blocking",  RSI_WAIT_BLOCKING  },
+    { "epoll",     RSI_WAIT_EPOLL     },
+    { "hybrid",    RSI_WAIT_HYBRID    },
+};
+
+static const Choice PRIORITIES[] = {
+    { "normal", RSI_SCHED_OTHER },
+    { "fifo",   RSI_SCHED_FIFO  },
+};
+
+static const Choice SIZES[] = {
+    { "small",   SIZE_SMALL   },
+    { "typical", SIZE_TYPICAL },
+    { "large",   SIZE_LARGE   },
+};
+
+static const Choice STRESSES[] = {
+    { "none",   STRESS_NONE   },
+    { "cpu",    STRESS_CPU    },
+    { "memory", STRESS_MEMORY },
+};
+
+#define COUNT(table) ((int)(sizeof(table) / sizeof((table)[0])))
+
+/* Indices into a table, or CPU numbers (-1 for unpinned) */
+typedef struct {
+    int values[MAX_CHOICES];
+    int count;
+} Sweep;
+
+static bool parse_sweep(const char* spec, const Choice* table, int table_size, Sweep* sweep) {
+    char list[256];
+    char* save = NULL;
+
+    if (strlen(spec) >= sizeof(list)) {
+        return false;
+    }
+    strcpy(list, spec);
+    sweep->count = 0;
+
+    for (char* item = strtok_r(list, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        int value = -1;
+        if (table) {
+            for (int i = 0; i < table_size; i++) {
+                if (strcmp(item, table[i].name) == 0) {
+                    value = i;
+                }
+            }
+            if (value < 0) {
+                return false;
+            }
+        } else if (strcmp(item, "none") != 0) {
+            char* end;
+            long cpu = strtol(item, &end, 10);
+            if (*end || end == item || cpu < 0 || cpu > 63) {
+                return false;
+            }
+            value = (int)cpu;
+        }
+        if (sweep->count == MAX_CHOICES) {
+            return false;
+        }
+        sweep->values[sweep->count++] = value;
+    }
+    return sweep->count > 0;
+}
+
+static void sweep_all(int table_size, Sweep* sweep) {
+    sweep->count = table_size;
+    for (int i = 0; i < table_size; i++) {
+        sweep->values[i] = i;
+    }
+}
+
+typedef struct {
+    int wait;        /* Index into WAITS */
+    int cpu;         /* Network thread CPU, -1 for unpinned */
+    int priority;    /* Index into PRIORITIES */
+    int size;        /* Index into SIZES */
+    int stress;      /* Index into STRESSES */
+} Setup;
+
+/*─ Background load, in child processes so it does not count as library CPU ─*/
+static pid_t g_workers[MAX_WORKERS];
+static int   g_worker_count;
+
+static void stress_worker(int kind) {
+    #ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    #endif
+
+    if (kind == STRESS_CPU) {
+        volatile double x = 1.0;
+        for (;;) {
+            x = x * 0.999999 + 1.0;
+        }
+    }
+
+    unsigned char* buffer = malloc(STRESS_BYTES);
+    volatile unsigned char sink;
+    if (!buffer) {
+        _exit(1);
+    }
+    for (unsigned pass = 0;; pass++) {
+        memset(buffer, (int)pass, STRESS_BYTES / 2);
+        memcpy(buffer + STRESS_BYTES / 2, buffer, STRESS_BYTES / 2);
+        sink = buffer[pass % STRESS_BYTES];
+    }
+    (void)sink;
+}
+
+static void stop_stress(void) {
+    for (int i = 0; i < g_worker_count; i++) {
+        kill(g_workers[i], SIGKILL);
+        waitpid(g_workers[i], NULL, 0);
+    }
+    g_worker_count = 0;
+}
+
+static bool start_stress(int kind) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (kind == STRESS_NONE) {
+        return true;
+    }
+    for (long i = 0; i < cpus && g_worker_count < MAX_WORKERS; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            stop_stress();
+            return false;
+        }
+        if (pid == 0) {
+            stress_worker(kind);
+        }
+        g_workers[g_worker_count++] = pid;
+    }
+    struct timespec settle = { 0, SETTLE_MS * 1000000L };
+    nanosleep(&settle, NULL);
+    return true;
+}
+
+/*─ One configuration ─*/
+typedef struct {
+    bool            started;
+    bool            pinned;       /* Requested pinning was applied */
+    bool            prioritized;  /* Requested priority was applied */
+    int             sent;
+    int             answered;
+    double          rtt_p50_us;
+    double          rtt_p99_us;
+    RSI_Percentiles response;     /* Receive call returning to sendto returning */
+    bool            kernel;       /* Kernel receive timestamps were available */
+    double          kernel_p50_us;
+    double          kernel_p99_us;
+    double          kernel_max_us;
+    double          cpu_percent;
+} Result;
+
+static double percentile(const double* sorted, int count, int per_mille) {
+    return sorted[((long)count * per_mille) / 1000];
+}
+
+/* Kernel receive to send, from the per-cycle samples */
+static void kernel_latency(RSI_Handle rsi, int cycles, Result* result) {
+    RSI_Sample* samples = malloc((size_t)cycles * sizeof(RSI_Sample));
+    double*     kernel_us = malloc((size_t)cycles * sizeof(double));
+    size_t      count = 0;
+
+    if (samples && kernel_us &&
+        RSI_ReadSamplesH(rsi, samples, (size_t)cycles, &count) == RSI_SUCCESS && count > 0) {
+        for (size_t i = 0; i < count; i++) {
+            kernel_us[i] = (double)samples[i].receive_delay_us +
+                           (double)(samples[i].send_time_us - samples[i].receive_time_us);
+        }
+        qsort(kernel_us, count, sizeof(double), compare_double);
+        result->kernel_p50_us = percentile(kernel_us, (int)count, 500);
+        result->kernel_p99_us = percentile(kernel_us, (int)count, 990);
+        result->kernel_max_us = kernel_us[count - 1];
+    }
+    free(samples);
+    free(kernel_us);
+}
+
+static void run_setup(const Setup* setup, int seconds, uint16_t port, BenchRobot* robot, Result* result) {
+    static const char* const FORMATS[] = { SMALL_FORMAT, TYPICAL_FORMAT, g_large_format };
+    RSI_Config             cfg = {0};
+    RSI_Handle             rsi;
+    RSI_StartupDiagnostics diagnostics;
+    RSI_Statistics         stats;
+    pthread_t              thread;
+
+    memset(result, 0, sizeof(*result));
+    robot->port     = port;
+    robot->format   = FORMATS[SIZES[setup->size].value];
+    robot->cycles   = seconds * (1000000 / CYCLE_US);
+    robot->answered = 0;
+
+    cfg.local_ip          = "127.0.0.1";
+    cfg.local_port        = port;
+    cfg.timeout_ms        = 1000;
+    cfg.wait_strategy     = (RSI_WaitStrategy)WAITS[setup->wait].value;
+    cfg.sched_policy      = (RSI_SchedPolicy)PRIORITIES[setup->priority].value;
+    cfg.cpu_mask          = setup->cpu >= 0 ? 1ull << setup->cpu : 0;
+    cfg.kernel_timestamps = true;
+    cfg.sample_ring_size  = (uint32_t)robot->cycles;
+
+    if (!start_stress(STRESSES[setup->stress].value)) {
+        return;
+    }
+    if (RSI_Create(&cfg, &rsi) != RSI_SUCCESS) {
+        stop_stress();
+        return;
+    }
+    if (RSI_StartH(rsi) != RSI_SUCCESS) {
+        RSI_Destroy(rsi);
+        stop_stress();
+        return;
+    }
+
+    RSI_GetStartupDiagnosticsH(rsi, &diagnostics);
+    result->started     = true;
+    result->pinned      = diagnostics.affinity.status == RSI_SUCCESS;
+    result->prioritized = diagnostics.scheduling.status == RSI_SUCCESS;
+
+    double wall_start = now_us(CLOCK_MONOTONIC);
+    double cpu_start  = now_us(CLOCK_PROCESS_CPUTIME_ID);
+
+    pthread_create(&thread, NULL, bench_robot_thread, robot);
+    pthread_join(thread, NULL);
+
+    double cpu_ms  = (now_us(CLOCK_PROCESS_CPUTIME_ID) - cpu_start) / 1e3 - robot->cpu_ms;
+    double wall_ms = (now_us(CLOCK_MONOTONIC) - wall_start) / 1e3;
+
+    RSI_GetStatisticsH(rsi, &stats);
+    RSI_GetPercentilesH(rsi, &result->response);
+    result->kernel = stats.kernel_timestamps;
+    if (result->kernel) {
+        kernel_latency(rsi, robot->cycles, result);
+    }
+    RSI_Destroy(rsi);
+    stop_stress();
+
+    result->sent        = robot->cycles;
+    result->answered    = robot->answered;
+    result->cpu_percent = 100.0 * cpu_ms / wall_ms;
+    if (robot->answered > 0) {
+        qsort(robot->rtt_us, (size_t)robot->answered, sizeof(double), compare_double);
+        result->rtt_p50_us = percentile(robot->rtt_us, robot->answered, 500);
+        result->rtt_p99_us = percentile(robot->rtt_us, robot->answered, 990);
+    }
+}
+
+/*─ Output ─*/
+static void print_header(void) {
+    printf("%-9s %4s %-7s %-7s %-6s  %11s %8s %8s  %8s %8s %8s %8s  %8s %8s %8s  %6s\n",
+           "wait", "cpu", "prio", "size", "load", "answered", "rtt p50", "rtt p99",
+           "lib p50", "lib p99", "p99.9", "max", "krn p50", "krn p99", "max", "cpu");
+}
+
+static void print_row(const Setup* setup, const Result* result) {
+    char cpu[8];
+    char priority[8];
+
+    if (setup->cpu < 0) {
+        snprintf(cpu, sizeof(cpu), "-");
+    } else {
+        snprintf(cpu, sizeof(cpu), "%d%s", setup->cpu, result->pinned ? "" : "!");
+    }
+    snprintf(priority, sizeof(priority), "%s%s", PRIORITIES[setup->priority].name,
+             PRIORITIES[setup->priority].value == RSI_SCHED_OTHER || result->prioritized ? "" : "!");
+
+    printf("%-9s %4s %-7s %-7s %-6s  ", WAITS[setup->wait].name, cpu, priority,
+           SIZES[setup->size].name, STRESSES[setup->stress].name);
+    if (!result->started) {
+        printf("failed to start\n");
+        return;
+    }
+    printf("%5d/%-5d %8.1f %8.1f  %8.1f %8.1f %8.1f %8.1f  ",
+           result->answered, result->sent, result->rtt_p50_us, result->rtt_p99_us,
+           result->response.p50_ms * 1e3, result->response.p99_ms * 1e3,
+           result->response.p999_ms * 1e3, result->response.max_ms * 1e3);
+    if (result->kernel) {
+        printf("%8.0f %8.0f %8.0f  ", result->kernel_p50_us, result->kernel_p99_us, result->kernel_max_us);
+    } else {
+        printf("%8s %8s %8s  ", "-", "-", "-");
+    }
+    printf("%5.1f%%\n", result->cpu_percent);
+    fflush(stdout);
+}
+
+static void print_json(const Setup* setup, const Result* result, bool first) {
+    printf("%s\n    {\n", first ? "" : ",");
+    printf("      \"wait\": \"%s\",\n", WAITS[setup->wait].name);
+    if (setup->cpu < 0) {
+        printf("      \"cpu\": null,\n");
+    } else {
+        printf("      \"cpu\": %d,\n", setup->cpu);
+    }
+    printf("      \"priority\": \"%s\",\n", PRIORITIES[setup->priority].name);
+    printf("      \"size\": \"%s\",\n", SIZES[setup->size].name);
+    printf("      \"load\": \"%s\",\n", STRESSES[setup->stress].name);
+    printf("      \"started\": %s", result->started ? "true" : "false");
+    if (result->started) {
+        printf(",\n      \"pinned\": %s,\n", result->pinned ? "true" : "false");
+        printf("      \"prioritized\": %s,\n", result->prioritized ? "true" : "false");
+        printf("      \"sent\": %d,\n", result->sent);
+        printf("      \"answered\": %d,\n", result->answered);
+        printf("      \"round_trip_us\": { \"p50\": %.1f, \"p99\": %.1f },\n",
+               result->rtt_p50_us, result->rtt_p99_us);
+        printf("      \"response_us\": { \"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, "
+               "\"p999\": %.2f, \"max\": %.2f },\n",
+               result->response.p50_ms * 1e3, result->response.p90_ms * 1e3,
+               result->response.p99_ms * 1e3, result->response.p999_ms * 1e3,
+               result->response.max_ms * 1e3);
+        if (result->kernel) {
+            printf("      \"kernel_to_send_us\": { \"p50\": %.0f, \"p99\": %.0f, \"max\": %.0f },\n",
+                   result->kernel_p50_us, result->kernel_p99_us, result->kernel_max_us);
+        } else {
+            printf("      \"kernel_to_send_us\": null,\n");
+        }
+        printf("      \"cpu_percent\": %.2f", result->cpu_percent);
+    }
+    printf("\n    }");
+    fflush(stdout);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s [-d seconds per configuration] [-p port] [-j]\n"
+            "          [-w busy-poll,blocking,epoll,hybrid] [-c none,CPU,...]\n"
+            "          [-r normal,fifo] [-s small,typical,large] [-x none,cpu,memory]\n",
+            program);
+}
+
+int main(int argc, char** argv)
+{
+    int      seconds = 2;
+    uint16_t port    = 59152;
+    bool     json    = false;
+    long     cpus    = sysconf(_SC_NPROCESSORS_ONLN);
+    Sweep    waits, pins, priorities, sizes, stresses;
+    int      opt;
+
+    sweep_all(COUNT(WAITS), &waits);
+    sweep_all(COUNT(PRIORITIES), &priorities);
+    sweep_all(COUNT(STRESSES), &stresses);
+    sizes.values[0] = SIZE_TYPICAL;
+    sizes.count = 1;
+    pins.values[0] = -1;
+    pins.count = 1;
+    if (cpus > 1) {
+        pins.values[pins.count++] = (int)(cpus > 64 ? 63 : cpus - 1);
+    }
+
+    while ((opt = getopt(argc, argv, "d:p:jw:c:r:s:x:")) != -1) {
+        bool valid = true;
+        switch (opt) {
+            case 'd': seconds = atoi(optarg); break;
+            case 'p': port = (uint16_t)atoi(optarg); break;
+            case 'j': json = true; break;
+            case 'w': valid = parse_sweep(optarg, WAITS, COUNT(WAITS), &waits); break;
+            case 'c': valid = parse_sweep(optarg, NULL, 0, &pins); break;
+            case 'r': valid = parse_sweep(optarg, PRIORITIES, COUNT(PRIORITIES), &priorities); break;
+            case 's': valid = parse_sweep(optarg, SIZES, COUNT(SIZES), &sizes); break;
+            case 'x': valid = parse_sweep(optarg, STRESSES, COUNT(STRESSES), &stresses); break;
+            default:  valid = false; break;
+        }
+        if (!valid) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (seconds <= 0 || seconds > 3600 || optind < argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    static BenchRobot robot;
+    robot.rtt_us = malloc((size_t)seconds * (1000000 / CYCLE_US) * sizeof(double));
+    if (!robot.rtt_us) {
+        perror("rsi_bench");
+        return 1;
+    }
+    build_large_format();
+
+    int configurations = waits.count * pins.count * priorities.count * sizes.count * stresses.count;
+    if (json) {
+        printf("{\n  \"benchmark\": \"rsi_bench\",\n  \"seconds\": %d,\n  \"cycle_us\": %d,\n"
+               "  \"cpus\": %ld,\n  \"configurations\": [", seconds, CYCLE_US, cpus);
+    } else {
+        printf("RSI on loopback, %d configurations, %d s each, %d us cycle, %ld CPUs, times in us\n\n",
+               configurations, seconds, CYCLE_US, cpus);
+        print_header();
+    }
+
+    // Wait strategy varies fastest, so neighbouring rows compare strategies
+    bool refused = false;
+    int  done = 0;
+    for (int s = 0; s < sizes.count; s++)
+    for (int x = 0; x < stresses.count; x++)
+    for (int r = 0; r < priorities.count; r++)
+    for (int c = 0; c < pins.count; c++)
+    for (int w = 0; w < waits.count; w++) {
+        Setup  setup = { waits.values[w], pins.values[c], priorities.values[r],
+                         sizes.values[s], stresses.values[x] };
+        Result result;
+
+        run_setup(&setup, seconds, port, &robot, &result);
+        refused |= result.started &&
+                   ((setup.cpu >= 0 && !result.pinned) ||
+                    (PRIORITIES[setup.priority].value != RSI_SCHED_OTHER && !result.prioritized));
+        if (json) {
+            print_json(&setup, &result, done == 0);
+        } else {
+            print_row(&setup, &result);
+        }
+        done++;
+    }
+
+    if (json) {
+        printf("\n  ]\n}\n");
+    } else if (refused) {
+        printf("\n! refused by the system (see RSI_GetStartupDiagnostics), e.g. without CAP_SYS_NICE\n");
+    }
+
+    free(robot.rtt_us);
+    return 0;
+}
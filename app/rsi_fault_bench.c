@@ -0,0 +1,435 @@
+/* rsi_fault_bench.c – library behaviour under network faults
+ *---------------------------------------------------------------------*
+ *  • Runs the library against a simulated robot on loopback that sends *
+ *    one packet every 4 ms through a fault-injection stage, once per   *
+ *    fault profile.                                                    *
+ *  • Profiles are comma-separated faults; random ones use a fixed      *
+ *    seed, so runs are repeatable:                                     *
+ *      drop=P         drop P % of the packets                          *
+ *      burst=N@MS     drop N packets in a row every MS ms              *
+ *      dup=P          send P % of the packets twice                    *
+ *      reorder=P      hold P % back until after the next packet        *
+ *      delay=MIN-MAX  add MIN..MAX ms of latency, keeping the order    *
+ *      stall=MS@EVERY hold all packets for MS ms every EVERY ms, then  *
+ *                     release them at once                             *
+ *    Without profiles a built-in set runs, from clean to disconnect.   *
+ *  • Reports, per profile, the round trip seen by the robot, the       *
+ *    library's response and jitter percentiles, its IPOC continuity    *
+ *    counters and the gap and disconnect callbacks it raised.          *
+ *  • Usage:  rsi_fault_bench [-d seconds per profile] [-p port]        *
+ *                            [-s seed] [profile ...]                   *
+ *  • POSIX only.                                                       *
+ *---------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "kuka_rsi.h"
+#include "bench_common.h"
+
+#define CYCLE_MS     (CYCLE_US / 1000)
+#define MAX_PENDING  4096       /* Packets held by the fault stage */
+#define DRAIN_MS     50         /* Wait for the last responses */
+
+static const char* const BUILTIN_PROFILES[] = {
+    "clean",
+    "drop=1",
+    "burst=5@1000",
+    "dup=1",
+    "reorder=1",
+    "delay=0-3",
+    "stall=5@1000",
+    "drop=1,dup=1,reorder=1,delay=0-2",
+    "stall=1500@2500",
+};
+
+/*─ Fault profile ─*/
+typedef struct {
+    const char* name;
+    double drop;                /* Percent */
+    int    burst;               /* Packets dropped in a row */
+    int    burst_every_ms;
+    double duplicate;           /* Percent */
+    double reorder;             /* Percent */
+    double delay_min_ms;
+    double delay_max_ms;
+    double stall_ms;
+    int    stall_every_ms;
+} Profile;
+
+static bool parse_profile(const char* spec, Profile* profile) {
+    char  copy[256];
+    char* save;
+
+    memset(profile, 0, sizeof(*profile));
+    profile->name = spec;
+    if (strcmp(spec, "clean") == 0) {
+        return true;
+    }
+    if (strlen(spec) >= sizeof(copy)) {
+        return false;
+    }
+    strcpy(copy, spec);
+
+    for (char* fault = strtok_r(copy, ",", &save); fault; fault = strtok_r(NULL, ",", &save)) {
+        if (sscanf(fault, "drop=%lf", &profile->drop) == 1 ||
+            sscanf(fault, "dup=%lf", &profile->duplicate) == 1 ||
+            sscanf(fault, "reorder=%lf", &profile->reorder) == 1 ||
+            sscanf(fault, "burst=%d@%d", &profile->burst, &profile->burst_every_ms) == 2 ||
+            sscanf(fault, "delay=%lf-%lf", &profile->delay_min_ms, &profile->delay_max_ms) == 2 ||
+            sscanf(fault, "stall=%lf@%d", &profile->stall_ms, &profile->stall_every_ms) == 2) {
+            continue;
+        }
+        return false;
+    }
+
+    return profile->delay_max_ms >= profile->delay_min_ms &&
+           (profile->burst == 0 || profile->burst_every_ms > 0) &&
+           (profile->stall_ms == 0 || profile->stall_every_ms > 0);
+}
+
+/*─ Repeatable randomness (xorshift64) ─*/
+static uint64_t g_random;
+
+static double random_unit(void) {
+    g_random ^= g_random << 13;
+    g_random ^= g_random >> 7;
+    g_random ^= g_random << 17;
+    return (double)(g_random >> 11) / 9007199254740992.0;
+}
+
+static bool chance(double percent) {
+    return percent > 0.0 && random_unit() * 100.0 < percent;
+}
+
+/*─ Simulated robot behind the fault stage ─*/
+typedef struct {
+    uint64_t release_ns;
+    uint32_t ipoc;
+} Pending;
+
+typedef struct {
+    int       sock;
+    struct sockaddr_in addr;
+    int       cycles;
+    uint64_t* sent_ns;          /* First send of each cycle's packet, 0 if never sent */
+    double*   rtt_us;
+    int       answered;
+    int       dropped;
+    Pending   pending[MAX_PENDING];
+    int       pending_count;
+    uint64_t  last_release_ns;  /* Delayed packets keep their order */
+} Robot;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Queue a packet, after any packet due at the same time */
+static void schedule(Robot* robot, uint32_t ipoc, uint64_t release_ns) {
+    int i = robot->pending_count;
+
+    if (i == MAX_PENDING) {
+        robot->dropped++;
+        return;
+    }
+    for (; i > 0 && robot->pending[i - 1].release_ns > release_ns; i--) {
+        robot->pending[i] = robot->pending[i - 1];
+    }
+    robot->pending[i].release_ns = release_ns;
+    robot->pending[i].ipoc = ipoc;
+    robot->pending_count++;
+}
+
+static void send_due(Robot* robot, uint64_t now) {
+    char packet[1024];
+    int  due = 0;
+
+    while (due < robot->pending_count && robot->pending[due].release_ns <= now) {
+        uint32_t ipoc = robot->pending[due++].ipoc;
+        int      len  = snprintf(packet, sizeof(packet), TYPICAL_FORMAT, ipoc);
+        int      cycle = (int)((ipoc - IPOC_START) / CYCLE_MS);
+
+        sendto(robot->sock, packet, (size_t)len, 0, (struct sockaddr*)&robot->addr, sizeof(robot->addr));
+        if (robot->sent_ns[cycle] == 0) {
+            robot->sent_ns[cycle] = now_ns();
+        }
+    }
+
+    memmove(robot->pending, robot->pending + due, (size_t)(robot->pending_count - due) * sizeof(Pending));
+    robot->pending_count -= due;
+}
+
+static void receive_until(Robot* robot, uint64_t deadline) {
+    char response[1024];
+
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= deadline) {
+            return;
+        }
+
+        fd_set readable;
+        struct timespec timeout = { (time_t)((deadline - now) / 1000000000ULL),
+                                    (long)((deadline - now) % 1000000000ULL) };
+        FD_ZERO(&readable);
+        FD_SET(robot->sock, &readable);
+        if (pselect(robot->sock + 1, &readable, NULL, NULL, &timeout, NULL) <= 0) {
+            continue;
+        }
+
+        ssize_t received = recv(robot->sock, response, sizeof(response) - 1, 0);
+        uint64_t arrival = now_ns();
+        if (received <= 0) {
+            continue;
+        }
+        response[received] = '\0';
+
+        // Count the first response per IPOC
+        uint32_t ipoc = response_ipoc(response);
+        if (ipoc < IPOC_START) {
+            continue;
+        }
+        int cycle = (int)((ipoc - IPOC_START) / CYCLE_MS);
+        if (cycle >= 0 && cycle < robot->cycles && robot->sent_ns[cycle] != 0 &&
+            robot->rtt_us[cycle] < 0.0) {
+            robot->rtt_us[cycle] = (double)(arrival - robot->sent_ns[cycle]) / 1e3;
+            robot->answered++;
+        }
+    }
+}
+
+static void run_robot(Robot* robot, const Profile* profile) {
+    uint64_t start      = now_ns();
+    uint64_t next_burst = start + (uint64_t)profile->burst_every_ms * 1000000ULL;
+    uint64_t next_stall = start + (uint64_t)profile->stall_every_ms * 1000000ULL;
+    uint64_t stall_end  = 0;
+    int      burst_left = 0;
+    bool     holding    = false;
+    uint32_t held_ipoc  = 0;
+
+    for (int i = 0; i < robot->cycles || robot->pending_count > 0 || holding; ) {
+        uint64_t generate = i < robot->cycles ? start + (uint64_t)i * CYCLE_MS * 1000000ULL : UINT64_MAX;
+        uint64_t release  = robot->pending_count > 0 ? robot->pending[0].release_ns : UINT64_MAX;
+        uint64_t wake     = generate < release ? generate : release;
+
+        // The robot stopped generating, so a held packet has no successor
+        if (wake == UINT64_MAX) {
+            schedule(robot, held_ipoc, now_ns());
+            holding = false;
+            continue;
+        }
+
+        receive_until(robot, wake);
+        uint64_t now = now_ns();
+        send_due(robot, now);
+        if (now < generate) {
+            continue;
+        }
+
+        uint32_t ipoc = IPOC_START + (uint32_t)i * CYCLE_MS;
+        i++;
+
+        if (profile->burst > 0 && generate >= next_burst) {
+            burst_left = profile->burst;
+            next_burst += (uint64_t)profile->burst_every_ms * 1000000ULL;
+        }
+        if (profile->stall_ms > 0 && generate >= next_stall) {
+            stall_end = generate + (uint64_t)(profile->stall_ms * 1e6);
+            next_stall += (uint64_t)profile->stall_every_ms * 1000000ULL;
+        }
+
+        if (burst_left > 0 || chance(profile->drop)) {
+            burst_left -= burst_left > 0;
+            robot->dropped++;
+            continue;
+        }
+
+        uint64_t due = generate;
+        if (profile->delay_max_ms > 0.0) {
+            double delay_ms = profile->delay_min_ms +
+                              random_unit() * (profile->delay_max_ms - profile->delay_min_ms);
+            due += (uint64_t)(delay_ms * 1e6);
+        }
+        if (due < stall_end) {
+            due = stall_end;
+        }
+        if (due < robot->last_release_ns) {
+            due = robot->last_release_ns;
+        }
+        robot->last_release_ns = due;
+
+        if (!holding && chance(profile->reorder)) {
+            holding = true;
+            held_ipoc = ipoc;
+            continue;
+        }
+
+        schedule(robot, ipoc, due);
+        if (chance(profile->duplicate)) {
+            schedule(robot, ipoc, due);
+        }
+        if (holding) {
+            schedule(robot, held_ipoc, due);
+            holding = false;
+        }
+    }
+
+    receive_until(robot, now_ns() + DRAIN_MS * 1000000ULL);
+}
+
+/*─ Library callbacks, read after RSI_Stop() ─*/
+static int g_disconnects;
+static int g_gaps;
+
+static void on_connection(bool connected, void* user_data) {
+    (void)user_data;
+    g_disconnects += !connected;
+}
+
+static void on_gap(const RSI_IpocGap* gap, void* user_data) {
+    (void)gap;
+    (void)user_data;
+    g_gaps++;
+}
+
+/*─ One profile ─*/
+static void run_profile(const Profile* profile, int seconds, uint16_t port, Robot* robot) {
+    RSI_Config     cfg = {0};
+    RSI_Statistics stats;
+
+    cfg.local_ip      = "127.0.0.1";
+    cfg.local_port    = port;
+    cfg.timeout_ms    = 1000;
+    cfg.wait_strategy = RSI_WAIT_EPOLL;     /* A spinning FIFO thread starves the robot on one core */
+
+    g_disconnects = 0;
+    g_gaps = 0;
+    if (RSI_Init(&cfg) != RSI_SUCCESS ||
+        RSI_SetCallbacks(NULL, on_connection, NULL) != RSI_SUCCESS ||
+        RSI_SetGapCallback(on_gap, NULL) != RSI_SUCCESS ||
+        RSI_Start() != RSI_SUCCESS) {
+        printf("%-34s  failed to start\n", profile->name);
+        RSI_Cleanup();
+        return;
+    }
+
+    robot->cycles        = seconds * (1000 / CYCLE_MS);
+    robot->answered      = 0;
+    robot->dropped       = 0;
+    robot->pending_count = 0;
+    robot->last_release_ns = 0;
+    memset(robot->sent_ns, 0, (size_t)robot->cycles * sizeof(uint64_t));
+    for (int i = 0; i < robot->cycles; i++) {
+        robot->rtt_us[i] = -1.0;
+    }
+    memset(&robot->addr, 0, sizeof(robot->addr));
+    robot->addr.sin_family      = AF_INET;
+    robot->addr.sin_port        = htons(port);
+    robot->addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    run_robot(robot, profile);
+
+    RSI_GetStatistics(&stats);
+    RSI_Stop();
+    RSI_Cleanup();
+
+    // Compact the answered cycles for the percentiles
+    int count = 0;
+    for (int i = 0; i < robot->cycles; i++) {
+        if (robot->rtt_us[i] >= 0.0) {
+            robot->rtt_us[count++] = robot->rtt_us[i];
+        }
+    }
+    qsort(robot->rtt_us, (size_t)count, sizeof(double), compare_double);
+
+    printf("%-34s  %5d/%-5d %5d %8.1f %8.1f %9.1f %10.1f %10.3f %7llu %4u %4llu %4llu %5llu %4d %4d\n",
+           profile->name, robot->answered, robot->cycles, robot->dropped,
+           count ? robot->rtt_us[count / 2] : 0.0,
+           count ? robot->rtt_us[(count * 99) / 100] : 0.0,
+           count ? robot->rtt_us[count - 1] : 0.0,
+           stats.p99_response_time_ms * 1e3, stats.p99_jitter_ms,
+           (unsigned long long)stats.ipoc_missing_cycles, stats.ipoc_longest_gap,
+           (unsigned long long)stats.ipoc_duplicates, (unsigned long long)stats.ipoc_out_of_order,
+           (unsigned long long)stats.stale_packets_dropped, g_gaps, g_disconnects);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [-d seconds per profile] [-p port] [-s seed] [profile...]\n"
+                    "profile: clean, or comma-separated drop=P burst=N@MS dup=P reorder=P\n"
+                    "         delay=MIN-MAX stall=MS@EVERY (P in %%, times in ms)\n", program);
+}
+
+int main(int argc, char** argv)
+{
+    int      seconds = 5;
+    uint16_t port    = 59152;
+    uint64_t seed    = 1;
+    int      opt;
+
+    while ((opt = getopt(argc, argv, "d:p:s:")) != -1) {
+        switch (opt) {
+            case 'd': seconds = atoi(optarg); break;
+            case 'p': port = (uint16_t)atoi(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:  usage(argv[0]); return 1;
+        }
+    }
+
+    const char* const* specs = BUILTIN_PROFILES;
+    int profiles = (int)(sizeof(BUILTIN_PROFILES) / sizeof(BUILTIN_PROFILES[0]));
+    if (optind < argc) {
+        specs = (const char* const*)&argv[optind];
+        profiles = argc - optind;
+    }
+
+    Profile parsed[64];
+    if (seconds <= 0 || profiles > 64 || seed == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (int i = 0; i < profiles; i++) {
+        if (!parse_profile(specs[i], &parsed[i])) {
+            fprintf(stderr, "bad profile: %s\n", specs[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    static Robot robot;
+    int cycles = seconds * (1000 / CYCLE_MS);
+    robot.sent_ns = malloc((size_t)cycles * sizeof(uint64_t));
+    robot.rtt_us  = malloc((size_t)cycles * sizeof(double));
+    robot.sock    = socket(AF_INET, SOCK_DGRAM, 0);
+    if (!robot.sent_ns || !robot.rtt_us || robot.sock < 0) {
+        perror("rsi_fault_bench");
+        return 1;
+    }
+
+    printf("RSI under network faults, %d s per profile, %d ms cycle on loopback, seed %llu\n\n",
+           seconds, CYCLE_MS, (unsigned long long)seed);
+    printf("%-34s  %11s %5s %8s %8s %9s %10s %10s %7s %4s %4s %4s %5s %4s %4s\n",
+           "profile", "answered", "lost", "p50 us", "p99 us", "max us", "lib p99 us", "jit p99 ms",
+           "missing", "run", "dup", "ooo", "stale", "gaps", "disc");
+
+    for (int i = 0; i < profiles; i++) {
+        g_random = seed;
+        run_profile(&parsed[i], seconds, port, &robot);
+    }
+
+    close(robot.sock);
+    free(robot.sent_ns);
+    free(robot.rtt_us);
+    return 0;
+}
@@ -0,0 +1,620 @@
+/* rsi_microbench.c – RSI parser hot-path microbenchmark
+ *---------------------------------------------------------------------*
+ *  • Runs a corpus of robot packets (minimal, typical, Tech-heavy and  *
+ *    a truncated, malformed one) through each step of the hot path:    *
+ *    tokenizing and IPOC extraction, RIst/AIPos parsing, rendering the *
+ *    response, and the whole per-packet path without socket I/O.       *
+ *  • Reports ns/packet, cycles/byte (with the TSC clock) and heap      *
+ *    allocations/packet (Linux builds, counted by wrapping malloc).    *
+ *  • Times the structural scanner (scalar / SSE2 / AVX2) and the       *
+ *    numeric codec against strtod/snprintf.                            *
+ *  • Cross-checks every scanner against the scalar reference and the   *
+ *    numeric codec against strtod/snprintf before timing anything.     *
+ *  • --json writes the results as JSON, for diffing runs.              *
+ *  • Usage:  rsi_microbench [--json] [iterations]                      *
+ *---------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+#endif
+
+#include "../src/internal.h"
+
+#define BENCH_PORT  59160       /* Bound by the benchmark instance, never receives */
+#define MAX_SCANNERS 8
+
+/*─ Heap allocations, counted with -Wl,--wrap (see CMakeLists.txt) ─*/
+#ifdef RSI_COUNT_ALLOCATIONS
+static size_t g_allocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+int   __real_posix_memalign(void** ptr, size_t alignment, size_t size);
+
+void* __wrap_malloc(size_t size) { g_allocations++; return __real_malloc(size); }
+void* __wrap_calloc(size_t count, size_t size) { g_allocations++; return __real_calloc(count, size); }
+void* __wrap_realloc(void* ptr, size_t size) { g_allocations++; return __real_realloc(ptr, size); }
+int   __wrap_posix_memalign(void** ptr, size_t alignment, size_t size) {
+    g_allocations++;
+    return __real_posix_memalign(ptr, alignment, size);
+}
+
+#define ALLOCATION_COUNTING 1
+#define ALLOCATIONS() g_allocations
+#else
+#define ALLOCATION_COUNTING 0
+#define ALLOCATIONS() ((size_t)0)
+#endif
+
+/*─ Corpus ─*/
+static const char MINIMAL_PACKET[] =
+    "<Rob Type=\"KUKA\">"
+    "<RIst X=\"445.0\" Y=\"0.0\" Z=\"790.0\" A=\"180.0\" B=\"0.0\" C=\"-180.0\"/>"
+    "<AIPos A1=\"0.0\" A2=\"-90.0\" A3=\"90.0\" A4=\"0.0\" A5=\"90.0\" A6=\"0.0\"/>"
+    "<IPOC>435413237</IPOC>"
+    "</Rob>";
+
+static const char TYPICAL_PACKET[] =
+    "<Rob Type=\"KUKA\">\n"
+    "  <RIst X=\"445.0012\" Y=\"-0.0003\" Z=\"790.0000\" A=\"180.0000\" B=\"0.0000\" C=\"-179.9998\"/>\n"
+    "  <RSol X=\"445.0000\" Y=\"0.0000\" Z=\"790.0000\" A=\"-180.0000\" B=\"0.0000\" C=\"-180.0000\"/>\n"
+    "  <AIPos A1=\"-0.0001\" A2=\"-90.0000\" A3=\"90.0000\" A4=\"0.0000\" A5=\"90.0000\" A6=\"0.0000\"/>\n"
+    "  <ASol A1=\"-0.0000\" A2=\"-90.0000\" A3=\"90.0000\" A4=\"0.0000\" A5=\"90.0000\" A6=\"0.0000\"/>\n"
+    "  <Delay D=\"0\"/>\n"
+    "  <IPOC>435413237</IPOC>\n"
+    "</Rob>";
+
+static char g_large_packet[RSI_MAX_PACKET_SIZE];
+static char g_malformed_packet[RSI_MAX_PACKET_SIZE];
+
+static void build_large_packet(void) {
+    size_t len = 0;
+    int i, j;
+
+    len += (size_t)snprintf(g_large_packet + len, sizeof(g_large_packet) - len, "%.*s",
+                            (int)(strstr(TYPICAL_PACKET, "  <IPOC>") - TYPICAL_PACKET),
+                            TYPICAL_PACKET);
+    for (i = 1; i <= 6; i++) {
+        len += (size_t)snprintf(g_large_packet + len, sizeof(g_large_packet) - len, "  <Tech");
+        for (j = 1; j <= 10; j++) {
+            len += (size_t)snprintf(g_large_packet + len, sizeof(g_large_packet) - len,
+                                    " C%d%d=\"%.4f\"", i, j, i * 10.0 + j * 0.125);
+        }
+        len += (size_t)snprintf(g_large_packet + len, sizeof(g_large_packet) - len, "/>\n");
+    }
+    len += (size_t)snprintf(g_large_packet + len, sizeof(g_large_packet) - len, "  <Digout");
+    for (j = 1; j <= 16; j++) {
+        len += (size_t)snprintf(g_large_packet + len, sizeof(g_large_packet) - len, " o%d=\"%d\"", j, j & 1);
+    }
+    len += (size_t)snprintf(g_large_packet + len, sizeof(g_large_packet) - len,
+                            "/>\n  <DiL>0</DiL>\n  <Source1>8.0</Source1>\n"
+                            "  <IPOC>435413237</IPOC>\n</Rob>");
+}
+
+/* Cut off inside an attribute value, as a datagram truncated on the wire */
+static void build_malformed_packet(void) {
+    const char* cut = strstr(TYPICAL_PACKET, "A3=\"90.0") + 6;
+    memcpy(g_malformed_packet, TYPICAL_PACKET, (size_t)(cut - TYPICAL_PACKET));
+}
+
+typedef struct {
+    const char* name;
+    const char* data;
+    size_t      len;
+    bool        valid;          /* Expected to be answered */
+} CorpusPacket;
+
+static CorpusPacket g_corpus[] = {
+    { "minimal",    MINIMAL_PACKET,     0, true  },
+    { "typical",    TYPICAL_PACKET,     0, true  },
+    { "tech-heavy", g_large_packet,     0, true  },
+    { "malformed",  g_malformed_packet, 0, false },
+};
+#define CORPUS_SIZE (sizeof(g_corpus) / sizeof(g_corpus[0]))
+
+/*─ Helpers ─*/
+static uint64_t now_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (uint64_t)(count.QuadPart * 1000000000.0 / freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static volatile size_t g_sink;
+static uint16_t g_positions[RSI_MAX_PACKET_SIZE];
+static uint16_t g_reference[RSI_MAX_PACKET_SIZE];
+static RSI_Packet g_packet;
+static RSI_Packet g_parsed;     /* Tokenized once, for the steps after tokenizing */
+static RSI_Handle g_instance;
+static char g_response[RSI_MAX_PACKET_SIZE];
+static bool g_tsc;              /* Clock ticks are CPU reference cycles */
+
+static bool verify_scanners(const char* data, size_t len) {
+    size_t count, expected, k;
+    const RSI_ScanImplementation* impls = rsi_scan_available(&count);
+    const RSI_ScanImplementation* reference = &impls[count - 1];  /* scalar */
+
+    expected = reference->scan(data, len, g_reference);
+    for (k = 0; k < count; k++) {
+        size_t found = impls[k].scan(data, len, g_positions);
+        if (found != expected || memcmp(g_positions, g_reference, found * sizeof(uint16_t)) != 0) {
+            fprintf(stderr, "scanner %s disagrees with %s\n", impls[k].name, reference->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*─ Numeric codec checks ─*/
+static uint64_t g_rng = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_random(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+static bool check_parse(const char* str) {
+    double expected = strtod(str, NULL);
+    double actual = 0.0;
+
+    if (!rsi_parse_double(str, strlen(str), &actual)) {
+        fprintf(stderr, "rsi_parse_double rejected \"%s\"\n", str);
+        return false;
+    }
+    if (isnan(expected) ? !isnan(actual) : memcmp(&expected, &actual, sizeof(double)) != 0) {
+        fprintf(stderr, "rsi_parse_double(\"%s\") = %.17g, strtod = %.17g\n", str, actual, expected);
+        return false;
+    }
+    return true;
+}
+
+static bool check_format(double value) {
+    char expected[64];
+    char actual[64];
+
+    snprintf(expected, sizeof(expected), "%.4f", value);
+    if (rsi_format_fixed4(value, actual, sizeof(actual)) == 0 || strcmp(expected, actual) != 0) {
+        fprintf(stderr, "rsi_format_fixed4(%.17g) = \"%s\", printf = \"%s\"\n", value, actual, expected);
+        return false;
+    }
+    return check_parse(actual);
+}
+
+static bool verify_numbers(long samples) {
+    static const char* const SPECIAL[] = {
+        "0", "-0", "-0.0", "+1.5", "1e5", "-2.5E-3", "0.1", "0.30000000000000004",
+        "9007199254740993", "123456789012345678901234567890", "1.7976931348623157e308",
+        "4.9e-324", "0.00000000000000000000000001", "inf", "-INF", "nan", "0x1p-3"
+    };
+    static const double TIES[] = { 0.00005, 0.00015, 1.23445, -2.50005, 0.5, -0.00004, 1e12, -1e15 };
+    static const char* const INVALID[] = { "", "-", ".", "1.2.3", "12a", "1e", " " };
+    char str[64];
+    double value;
+    long i;
+
+    for (i = 0; i < (long)(sizeof(SPECIAL) / sizeof(SPECIAL[0])); i++) {
+        if (!check_parse(SPECIAL[i])) return false;
+    }
+    for (i = 0; i < (long)(sizeof(INVALID) / sizeof(INVALID[0])); i++) {
+        if (rsi_parse_double(INVALID[i], strlen(INVALID[i]), &value)) {
+            fprintf(stderr, "rsi_parse_double accepted \"%s\"\n", INVALID[i]);
+            return false;
+        }
+    }
+    for (i = 0; i < (long)(sizeof(TIES) / sizeof(TIES[0])); i++) {
+        if (!check_format(TIES[i])) return false;
+    }
+
+    for (i = 0; i < samples; i++) {
+        uint64_t r = next_random();
+        uint64_t bits = next_random();
+
+        // KUKA shape: -123.4567 and friends
+        snprintf(str, sizeof(str), "%s%llu.%0*llu", (r & 1) ? "-" : "",
+                 (unsigned long long)((r >> 1) % 100000),
+                 (int)((r >> 20) % 8) + 1,
+                 (unsigned long long)((r >> 24) % 100000000ULL));
+        if (!check_parse(str)) return false;
+
+        // Arbitrary doubles in shortest round-trip and exponent form
+        memcpy(&value, &bits, sizeof(value));
+        if (!isfinite(value)) continue;
+        snprintf(str, sizeof(str), "%.17g", value);
+        if (!check_parse(str)) return false;
+
+        // Formatting over the range corrections and positions live in
+        value = ((double)(r >> 11) / 9007199254740992.0 - 0.5) * 4000.0;
+        if (!check_format(value)) return false;
+    }
+
+    return true;
+}
+
+/* The instance must answer the valid packets and reject the malformed one */
+static bool verify_hot_path(void) {
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        int len = rsi_process_datagram(g_instance, g_corpus[i].data, g_corpus[i].len);
+        if ((len > 0) != g_corpus[i].valid) {
+            fprintf(stderr, "%s packet was %s\n", g_corpus[i].name, len > 0 ? "answered" : "not answered");
+            return false;
+        }
+    }
+    return true;
+}
+
+/*─ Hot-path steps ─*/
+typedef size_t (*StepFunction)(const CorpusPacket* packet);
+
+static size_t step_ipoc(const CorpusPacket* packet) {
+    uint32_t ipoc = 0;
+    if (rsi_tokenize_packet(packet->data, packet->len, &g_packet) && g_packet.ipoc) {
+        rsi_parse_uint32(g_packet.ipoc->text.ptr, g_packet.ipoc->text.len, &ipoc);
+    }
+    return ipoc;
+}
+
+static size_t step_positions(const CorpusPacket* packet) {
+    const RSI_Element* elements[2] = { g_parsed.rist, g_parsed.aipos };
+    double sum = 0.0;
+    (void)packet;
+
+    for (int e = 0; e < 2; e++) {
+        const RSI_Attribute* attr = &g_parsed.attributes[elements[e]->first_attribute];
+        for (uint16_t k = 0; k < elements[e]->attribute_count; k++, attr++) {
+            double value = 0.0;
+            rsi_parse_double(attr->value.ptr, attr->value.len, &value);
+            sum += value;
+        }
+    }
+    return (size_t)sum;
+}
+
+static size_t step_response(const CorpusPacket* packet) {
+    (void)packet;
+    return (size_t)rsi_generate_response(g_instance, "435413237", 9, g_response, sizeof(g_response));
+}
+
+/* Working copy for the whole path, whose IPOC advances like a robot's */
+static char  g_stream[RSI_MAX_PACKET_SIZE];
+static char* g_stream_ipoc;
+static char* g_stream_ipoc_end;
+
+static void advance_ipoc(void) {
+    int carry = 4;
+    for (char* digit = g_stream_ipoc_end - 1; digit >= g_stream_ipoc && carry; digit--) {
+        int value = *digit - '0' + carry;
+        *digit = (char)('0' + value % 10);
+        carry = value / 10;
+    }
+}
+
+static size_t step_process(const CorpusPacket* packet) {
+    if (g_stream_ipoc) {
+        advance_ipoc();
+    }
+    return (size_t)rsi_process_datagram(g_instance, g_stream, packet->len);
+}
+
+static const struct {
+    const char*  name;
+    StepFunction run;
+    bool         needs_valid;   /* Only meaningful for packets that tokenize */
+} STEPS[] = {
+    { "ipoc",      step_ipoc,      false },
+    { "positions", step_positions, true  },
+    { "response",  step_response,  true  },
+    { "process",   step_process,   false },
+};
+#define STEP_COUNT (sizeof(STEPS) / sizeof(STEPS[0]))
+
+/*─ Results ─*/
+typedef struct {
+    bool   measured;
+    double ns;                  /* Per packet */
+    double cycles_per_byte;     /* Negative without a cycle counter */
+    double allocations;         /* Per packet */
+} StepResult;
+
+typedef struct {
+    const char* name;
+    double      scan_ns;
+    double      token_ns;
+} ScannerResult;
+
+typedef struct {
+    StepResult    steps[STEP_COUNT];
+    ScannerResult scanners[MAX_SCANNERS];
+    size_t        scanner_count;
+} PacketResult;
+
+typedef struct {
+    size_t values;
+    double parse_ns, strtod_ns, format_ns, snprintf_ns;
+} NumberResult;
+
+static StepResult time_step(StepFunction run, const CorpusPacket* packet, long iterations) {
+    StepResult result = { true, 0.0, -1.0, 0.0 };
+    long i;
+
+    for (i = 0; i < iterations / 10; i++) {
+        g_sink += run(packet);
+    }
+
+    size_t   allocations = ALLOCATIONS();
+    uint64_t ticks = rsi_clock_ticks();
+    uint64_t t0 = now_ns();
+    for (i = 0; i < iterations; i++) {
+        g_sink += run(packet);
+    }
+    uint64_t t1 = now_ns();
+    ticks = rsi_clock_ticks() - ticks;
+
+    result.ns = (double)(t1 - t0) / iterations;
+    result.allocations = (double)(ALLOCATIONS() - allocations) / iterations;
+    if (g_tsc) {
+        result.cycles_per_byte = (double)ticks / iterations / (double)packet->len;
+    }
+    return result;
+}
+
+static void bench_steps(const CorpusPacket* packet, long iterations, PacketResult* out) {
+    bool tokenizes = rsi_tokenize_packet(packet->data, packet->len, &g_parsed) &&
+                     g_parsed.ipoc && g_parsed.rist && g_parsed.aipos;
+
+    memcpy(g_stream, packet->data, packet->len);
+    g_stream_ipoc = strstr(g_stream, "<IPOC>");
+    if (g_stream_ipoc) {
+        g_stream_ipoc += 6;
+        g_stream_ipoc_end = strchr(g_stream_ipoc, '<');
+    }
+
+    for (size_t s = 0; s < STEP_COUNT; s++) {
+        if (STEPS[s].needs_valid && !tokenizes) {
+            out->steps[s].measured = false;
+            continue;
+        }
+        out->steps[s] = time_step(STEPS[s].run, packet, iterations);
+    }
+}
+
+static void bench_scanners(const CorpusPacket* packet, long iterations, PacketResult* out) {
+    size_t count, k;
+    long i;
+    const RSI_ScanImplementation* impls = rsi_scan_available(&count);
+    const RSI_ScanImplementation* original = rsi_scan_active();
+
+    out->scanner_count = count < MAX_SCANNERS ? count : MAX_SCANNERS;
+    for (k = 0; k < out->scanner_count; k++) {
+        uint64_t t0, t1, t2;
+
+        t0 = now_ns();
+        for (i = 0; i < iterations; i++) {
+            g_sink += impls[k].scan(packet->data, packet->len, g_positions);
+        }
+        t1 = now_ns();
+
+        rsi_scan_use(&impls[k]);
+        for (i = 0; i < iterations; i++) {
+            g_sink += rsi_tokenize_packet(packet->data, packet->len, &g_packet);
+        }
+        t2 = now_ns();
+
+        out->scanners[k].name     = impls[k].name;
+        out->scanners[k].scan_ns  = (double)(t1 - t0) / iterations;
+        out->scanners[k].token_ns = (double)(t2 - t1) / iterations;
+    }
+
+    rsi_scan_use(original);
+}
+
+static void bench_numbers(long iterations, NumberResult* out) {
+    const RSI_Attribute* attrs[12];
+    size_t count = 0;
+    uint64_t t0, t1, t2, t3, t4;
+    char buffer[64];
+    long i;
+    size_t k;
+
+    rsi_tokenize_packet(TYPICAL_PACKET, strlen(TYPICAL_PACKET), &g_packet);
+    for (k = 0; k < g_packet.rist->attribute_count; k++) {
+        attrs[count++] = &g_packet.attributes[g_packet.rist->first_attribute + k];
+    }
+    for (k = 0; k < g_packet.aipos->attribute_count; k++) {
+        attrs[count++] = &g_packet.attributes[g_packet.aipos->first_attribute + k];
+    }
+
+    t0 = now_ns();
+    for (i = 0; i < iterations; i++) {
+        double sum = 0.0;
+        for (k = 0; k < count; k++) {
+            double v = 0.0;
+            rsi_parse_double(attrs[k]->value.ptr, attrs[k]->value.len, &v);
+            sum += v;
+        }
+        g_sink += (size_t)sum;
+    }
+    t1 = now_ns();
+    for (i = 0; i < iterations; i++) {
+        double sum = 0.0;
+        for (k = 0; k < count; k++) {
+            sum += strtod(attrs[k]->value.ptr, NULL);
+        }
+        g_sink += (size_t)sum;
+    }
+    t2 = now_ns();
+    for (i = 0; i < iterations; i++) {
+        for (k = 0; k < 6; k++) {
+            g_sink += (size_t)rsi_format_fixed4(-123.4567 + (double)k, buffer, sizeof(buffer));
+        }
+    }
+    t3 = now_ns();
+    for (i = 0; i < iterations; i++) {
+        for (k = 0; k < 6; k++) {
+            g_sink += (size_t)snprintf(buffer, sizeof(buffer), "%.4f", -123.4567 + (double)k);
+        }
+    }
+    t4 = now_ns();
+
+    out->values      = count;
+    out->parse_ns    = (double)(t1 - t0) / iterations;
+    out->strtod_ns   = (double)(t2 - t1) / iterations;
+    out->format_ns   = (double)(t3 - t2) / iterations;
+    out->snprintf_ns = (double)(t4 - t3) / iterations;
+}
+
+/*─ Output ─*/
+static void print_text(long iterations, const PacketResult* results, const NumberResult* numbers) {
+    printf("RSI parser microbenchmark, %ld iterations, default scanner: %s, clock: %s\n",
+           iterations, rsi_scan_active()->name, rsi_clock_name());
+
+    printf("\nHot path (allocations %s)\n", ALLOCATION_COUNTING ? "counted" : "not counted in this build");
+    printf("  %-10s %6s  %-10s %12s %10s %8s\n", "packet", "bytes", "step", "ns/packet", "cycles/B", "allocs");
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        for (size_t s = 0; s < STEP_COUNT; s++) {
+            const StepResult* r = &results[i].steps[s];
+            printf("  %-10s %6zu  %-10s", s == 0 ? g_corpus[i].name : "", g_corpus[i].len, STEPS[s].name);
+            if (!r->measured) {
+                printf(" %12s %10s %8s\n", "-", "-", "-");
+                continue;
+            }
+            printf(" %12.1f", r->ns);
+            if (r->cycles_per_byte >= 0.0) {
+                printf(" %10.2f", r->cycles_per_byte);
+            } else {
+                printf(" %10s", "-");
+            }
+            if (ALLOCATION_COUNTING) {
+                printf(" %8.2f\n", r->allocations);
+            } else {
+                printf(" %8s\n", "-");
+            }
+        }
+    }
+
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        printf("\n%s packet (%zu bytes)\n", g_corpus[i].name, g_corpus[i].len);
+        printf("  %-10s %12s %12s %12s %12s\n", "scanner", "scan ns", "scan B/ns", "token ns", "token B/ns");
+        for (size_t k = 0; k < results[i].scanner_count; k++) {
+            const ScannerResult* r = &results[i].scanners[k];
+            printf("  %-10s %12.1f %12.2f %12.1f %12.2f\n", r->name,
+                   r->scan_ns, g_corpus[i].len / r->scan_ns, r->token_ns, g_corpus[i].len / r->token_ns);
+        }
+    }
+
+    printf("\nNumeric codec (%zu doubles parsed, 6 formatted per packet)\n", numbers->values);
+    printf("  %-22s %12.1f ns/packet\n", "rsi_parse_double", numbers->parse_ns);
+    printf("  %-22s %12.1f ns/packet\n", "strtod", numbers->strtod_ns);
+    printf("  %-22s %12.1f ns/packet\n", "rsi_format_fixed4", numbers->format_ns);
+    printf("  %-22s %12.1f ns/packet\n", "snprintf %.4f", numbers->snprintf_ns);
+}
+
+static void print_json(long iterations, const PacketResult* results, const NumberResult* numbers) {
+    printf("{\n  \"benchmark\": \"rsi_microbench\",\n  \"iterations\": %ld,\n", iterations);
+    printf("  \"scanner\": \"%s\",\n  \"clock\": \"%s\",\n  \"tick_ns\": %.6f,\n",
+           rsi_scan_active()->name, rsi_clock_name(), rsi_clock_tick_ns());
+    printf("  \"allocations_counted\": %s,\n  \"packets\": [", ALLOCATION_COUNTING ? "true" : "false");
+
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        printf("%s\n    {\"name\": \"%s\", \"bytes\": %zu, \"steps\": {", i ? "," : "",
+               g_corpus[i].name, g_corpus[i].len);
+        for (size_t s = 0; s < STEP_COUNT; s++) {
+            const StepResult* r = &results[i].steps[s];
+            printf("%s\n      \"%s\": ", s ? "," : "", STEPS[s].name);
+            if (!r->measured) {
+                printf("null");
+                continue;
+            }
+            printf("{\"ns_per_packet\": %.2f, \"cycles_per_byte\": ", r->ns);
+            if (r->cycles_per_byte >= 0.0) {
+                printf("%.3f", r->cycles_per_byte);
+            } else {
+                printf("null");
+            }
+            if (ALLOCATION_COUNTING) {
+                printf(", \"allocations_per_packet\": %.3f}", r->allocations);
+            } else {
+                printf(", \"allocations_per_packet\": null}");
+            }
+        }
+        printf("},\n      \"scanners\": {");
+        for (size_t k = 0; k < results[i].scanner_count; k++) {
+            const ScannerResult* r = &results[i].scanners[k];
+            printf("%s\"%s\": {\"scan_ns\": %.2f, \"tokenize_ns\": %.2f}",
+                   k ? ", " : "", r->name, r->scan_ns, r->token_ns);
+        }
+        printf("}}");
+    }
+
+    printf("\n  ],\n  \"numbers\": {\"values\": %zu, \"rsi_parse_double_ns\": %.2f, \"strtod_ns\": %.2f, "
+           "\"rsi_format_fixed4_ns\": %.2f, \"snprintf_ns\": %.2f}\n}\n",
+           numbers->values, numbers->parse_ns, numbers->strtod_ns, numbers->format_ns, numbers->snprintf_ns);
+}
+
+int main(int argc, char** argv)
+{
+    bool json = argc > 1 && strcmp(argv[1], "--json") == 0;
+    long iterations = argc > 1 + json ? atol(argv[1 + json]) : 200000;
+    static PacketResult results[CORPUS_SIZE];
+    NumberResult numbers;
+
+    if (iterations <= 0 || argc > 2 + json) {
+        fprintf(stderr, "usage: %s [--json] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    build_large_packet();
+    build_malformed_packet();
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        g_corpus[i].len = strlen(g_corpus[i].data);
+    }
+    g_tsc = strcmp(rsi_clock_name(), "tsc") == 0;
+
+    // A stopped instance answers with the zero correction rendered at init
+    RSI_Config cfg = {0};
+    cfg.local_ip   = "127.0.0.1";
+    cfg.local_port = BENCH_PORT;
+    if (RSI_Create(&cfg, &g_instance) != RSI_SUCCESS) {
+        fprintf(stderr, "could not create the benchmark instance on port %d\n", BENCH_PORT);
+        return 1;
+    }
+
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        if (!verify_scanners(g_corpus[i].data, g_corpus[i].len)) {
+            return 1;
+        }
+    }
+    if (!verify_numbers(1000000) || !verify_hot_path()) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        bench_steps(&g_corpus[i], iterations, &results[i]);
+        bench_scanners(&g_corpus[i], iterations, &results[i]);
+    }
+    bench_numbers(iterations, &numbers);
+
+    RSI_Destroy(g_instance);
+
+    if (json) {
+        print_json(iterations, results, &numbers);
+    } else {
+        print_text(iterations, results, &numbers);
+    }
+    return 0;
+}
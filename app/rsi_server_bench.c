@@ -0,0 +1,309 @@
+/* rsi_server_bench.c – per-robot latency with many robots in one process
+ *---------------------------------------------------------------------*
+ *  • Simulates N robots on loopback, each sending one packet every     *
+ *    4 ms to its own port, with the send phases spread over the cycle. *
+ *  • Serves them with one network thread per robot, then with an       *
+ *    event-loop server on 1 and on T threads.                          *
+ *  • Reports the round trip seen by each robot, counting only the      *
+ *    response with the IPOC of its last packet that arrives within     *
+ *    the cycle (p99 per robot, plus p50 / p99 / max over all robots),  *
+ *    and the CPU time the library burns, as a share of one core.       *
+ *  • Usage:  rsi_server_bench [robots] [seconds] [threads] [base port] *
+ *  • POSIX only (uses pthreads and CLOCK_THREAD_CPUTIME_ID).           *
+ *---------------------------------------------------------------------*/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // ppoll
+#endif
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "kuka_rsi.h"
+#include "bench_common.h"
+
+#define MAX_ROBOTS   256
+
+/*─ Simulated robots, all driven from one thread ─*/
+typedef struct {
+    int      robots;
+    int      cycles;
+    uint16_t base_port;
+    double*  rtt_us;          /* robots x cycles */
+    int*     received;        /* per robot */
+    double   cpu_ms;
+} Cell;
+
+static void sleep_poll(struct pollfd* fds, int count, double timeout_us) {
+    #ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec  = (time_t)(timeout_us / 1e6);
+    timeout.tv_nsec = (long)((timeout_us - timeout.tv_sec * 1e6) * 1e3);
+    ppoll(fds, (nfds_t)count, &timeout, NULL);
+    #else
+    poll(fds, (nfds_t)count, (int)(timeout_us / 1e3));
+    #endif
+}
+
+/* Collect responses to the pending packets until `due` (CLOCK_MONOTONIC, us) */
+static void collect(Cell* cell, struct pollfd* fds, const double* sent, const uint32_t* sent_ipoc,
+                    int* pending, double due) {
+    char    response[1024];
+    ssize_t received;
+
+    for (;;) {
+        double now = now_us(CLOCK_MONOTONIC);
+        if (now >= due) {
+            return;
+        }
+
+        sleep_poll(fds, cell->robots, due - now);
+        now = now_us(CLOCK_MONOTONIC);
+
+        for (int r = 0; r < cell->robots; r++) {
+            if (!(fds[r].revents & POLLIN)) {
+                continue;
+            }
+            while ((received = recv(fds[r].fd, response, sizeof(response) - 1, MSG_DONTWAIT)) > 0) {
+                response[received] = '\0';
+                if (pending[r] && response_ipoc(response) == sent_ipoc[r]) {
+                    // An answer after the cycle is missed, as in bench_robot_thread
+                    if (now - sent[r] <= CYCLE_US) {
+                        cell->rtt_us[(size_t)r * cell->cycles + cell->received[r]++] = now - sent[r];
+                    }
+                    pending[r] = 0;
+                }
+            }
+        }
+    }
+}
+
+static void* cell_thread(void* arg) {
+    Cell*              cell = arg;
+    struct pollfd      fds[MAX_ROBOTS];
+    double             sent[MAX_ROBOTS];
+    uint32_t           sent_ipoc[MAX_ROBOTS];
+    int                pending[MAX_ROBOTS] = {0};
+    struct sockaddr_in addr;
+    char               packet[1024];
+    double             cpu_start = now_us(CLOCK_THREAD_CPUTIME_ID);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int r = 0; r < cell->robots; r++) {
+        fds[r].fd     = socket(AF_INET, SOCK_DGRAM, 0);
+        fds[r].events = POLLIN;
+    }
+
+    // Robot r sends r/robots of a cycle after robot 0, like unsynchronized controllers
+    double start = now_us(CLOCK_MONOTONIC) + CYCLE_US;
+    for (int k = 0; k < cell->cycles; k++) {
+        for (int r = 0; r < cell->robots; r++) {
+            double due = start + (double)k * CYCLE_US + (double)r * CYCLE_US / cell->robots;
+            collect(cell, fds, sent, sent_ipoc, pending, due);
+
+            sent_ipoc[r] = IPOC_START + (uint32_t)k * 4u;
+            int len = snprintf(packet, sizeof(packet), TYPICAL_FORMAT, sent_ipoc[r]);
+            addr.sin_port = htons((uint16_t)(cell->base_port + r));
+            sent[r]    = now_us(CLOCK_MONOTONIC);
+            pending[r] = 1;
+            sendto(fds[r].fd, packet, (size_t)len, 0, (struct sockaddr*)&addr, sizeof(addr));
+        }
+    }
+    collect(cell, fds, sent, sent_ipoc, pending, now_us(CLOCK_MONOTONIC) + CYCLE_US);
+
+    for (int r = 0; r < cell->robots; r++) {
+        close(fds[r].fd);
+    }
+    cell->cpu_ms = (now_us(CLOCK_THREAD_CPUTIME_ID) - cpu_start) / 1e3;
+    return NULL;
+}
+
+/*─ Run the cell against already started instances and print one row ─*/
+static void measure(const char* name, Cell* cell) {
+    pthread_t thread;
+    int       total = 0;
+
+    memset(cell->received, 0, sizeof(int) * (size_t)cell->robots);
+
+    double wall_start = now_us(CLOCK_MONOTONIC);
+    double cpu_start  = now_us(CLOCK_PROCESS_CPUTIME_ID);
+
+    pthread_create(&thread, NULL, cell_thread, cell);
+    pthread_join(thread, NULL);
+
+    double cpu_ms  = (now_us(CLOCK_PROCESS_CPUTIME_ID) - cpu_start) / 1e3 - cell->cpu_ms;
+    double wall_ms = (now_us(CLOCK_MONOTONIC) - wall_start) / 1e3;
+
+    // Per-robot p99 first, then everything merged (sorting in place is fine)
+    double  p99[MAX_ROBOTS];
+    double  worst = 0.0;
+    double* all   = malloc(sizeof(double) * (size_t)cell->robots * (size_t)cell->cycles);
+    for (int r = 0; r < cell->robots; r++) {
+        double* rtt = cell->rtt_us + (size_t)r * cell->cycles;
+        int     n   = cell->received[r];
+
+        qsort(rtt, (size_t)n, sizeof(double), compare_double);
+        p99[r] = n ? rtt[(n * 99) / 100] : 0.0;
+        if (p99[r] > worst) {
+            worst = p99[r];
+        }
+        memcpy(all + total, rtt, sizeof(double) * (size_t)n);
+        total += n;
+    }
+
+    if (total == 0) {
+        printf("%-14s  no responses\n", name);
+        free(all);
+        return;
+    }
+
+    qsort(all, (size_t)total, sizeof(double), compare_double);
+    printf("%-14s  %6d/%-6d  %8.1f  %8.1f  %9.1f  %8.1f  %6.1f%%\n",
+           name, total, cell->robots * cell->cycles,
+           all[total / 2], all[(total * 99) / 100], worst, all[total - 1],
+           100.0 * cpu_ms / wall_ms);
+
+    printf("  p99 by robot:");
+    for (int r = 0; r < cell->robots; r++) {
+        printf("%s%6.0f", (r % 12 == 0 && r) ? "\n               " : "", p99[r]);
+    }
+    printf("\n");
+    free(all);
+}
+
+static bool create_robots(RSI_Handle* handles, int robots, uint16_t base_port, RSI_WaitStrategy strategy) {
+    RSI_Config cfg = {0};
+
+    cfg.local_ip      = "127.0.0.1";
+    cfg.timeout_ms    = 1000;
+    cfg.wait_strategy = strategy;
+
+    for (int r = 0; r < robots; r++) {
+        cfg.local_port = (uint16_t)(base_port + r);
+        if (RSI_Create(&cfg, &handles[r]) != RSI_SUCCESS) {
+            while (r > 0) {
+                RSI_Destroy(handles[--r]);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+static void destroy_robots(RSI_Handle* handles, int robots) {
+    for (int r = 0; r < robots; r++) {
+        RSI_Destroy(handles[r]);
+    }
+}
+
+/*─ One network thread per robot ─*/
+static void run_threads(Cell* cell) {
+    RSI_Handle handles[MAX_ROBOTS];
+    int        started = 0;
+
+    if (!create_robots(handles, cell->robots, cell->base_port, RSI_WAIT_EPOLL)) {
+        printf("%-14s  failed to create\n", "thread/robot");
+        return;
+    }
+
+    while (started < cell->robots && RSI_StartH(handles[started]) == RSI_SUCCESS) {
+        started++;
+    }
+
+    if (started == cell->robots) {
+        measure("thread/robot", cell);
+    } else {
+        printf("%-14s  failed to start\n", "thread/robot");
+    }
+
+    for (int r = 0; r < started; r++) {
+        RSI_StopH(handles[r]);
+    }
+    destroy_robots(handles, cell->robots);
+}
+
+/*─ Event-loop server on `threads` threads ─*/
+static void run_server(Cell* cell, uint32_t threads) {
+    RSI_Handle       handles[MAX_ROBOTS];
+    RSI_ServerHandle server;
+    RSI_ServerConfig scfg = {0};
+    char             name[32];
+
+    snprintf(name, sizeof(name), "server x%u", threads);
+    scfg.thread_count = threads;
+
+    if (!create_robots(handles, cell->robots, cell->base_port, RSI_WAIT_EPOLL)) {
+        printf("%-14s  failed to create\n", name);
+        return;
+    }
+
+    if (RSI_ServerCreate(&scfg, &server) != RSI_SUCCESS) {
+        printf("%-14s  failed to create\n", name);
+        destroy_robots(handles, cell->robots);
+        return;
+    }
+
+    for (int r = 0; r < cell->robots; r++) {
+        RSI_ServerAdd(server, handles[r]);
+    }
+
+    if (RSI_ServerStart(server) == RSI_SUCCESS) {
+        measure(name, cell);
+    } else {
+        printf("%-14s  failed to start\n", name);
+    }
+
+    RSI_ServerDestroy(server);
+    destroy_robots(handles, cell->robots);
+}
+
+int main(int argc, char** argv)
+{
+    int      robots  = argc > 1 ? atoi(argv[1]) : 32;
+    int      seconds = argc > 2 ? atoi(argv[2]) : 5;
+    long     cpus    = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = argc > 3 ? (uint32_t)atoi(argv[3]) : (uint32_t)(cpus > 1 ? cpus : 2);
+    Cell     cell;
+
+    if (robots <= 0 || robots > MAX_ROBOTS || seconds <= 0 || threads == 0 || threads > 64) {
+        fprintf(stderr, "usage: %s [robots, 1-%d] [seconds per mode] [threads, 1-64] [base port]\n",
+                argv[0], MAX_ROBOTS);
+        return 1;
+    }
+
+    cell.robots    = robots;
+    cell.cycles    = seconds * (1000000 / CYCLE_US);
+    cell.base_port = argc > 4 ? (uint16_t)atoi(argv[4]) : 59152;
+    cell.rtt_us    = malloc(sizeof(double) * (size_t)robots * (size_t)cell.cycles);
+    cell.received  = malloc(sizeof(int) * (size_t)robots);
+    if (!cell.rtt_us || !cell.received) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("RSI server: %d robots, %d s per mode, %d us cycle on loopback, %ld CPUs\n\n",
+           robots, seconds, CYCLE_US, cpus);
+    printf("%-14s  %13s  %8s  %8s  %9s  %8s  %7s\n",
+           "mode", "responses", "p50 us", "p99 us", "worst p99", "max us", "cpu");
+
+    run_threads(&cell);
+    run_server(&cell, 1);
+    if (threads > 1) {
+        run_server(&cell, threads);
+    }
+
+    free(cell.rtt_us);
+    free(cell.received);
+    return 0;
+}
@@ -0,0 +1,549 @@
+/* rsi_sim.c – fake KUKA controller for testing without a robot
+ *---------------------------------------------------------------------*
+ *  • Sends a <Rob> packet (RIst, RSol, AIPos, ASol, Delay, Tech, IPOC) *
+ *    every 4 or 12 ms from one UDP socket, like a KRC running RSI.     *
+ *  • Adds the RKorr / AKorr of every response to its commanded pose    *
+ *    (relative corrections; -A treats them as offsets from the start   *
+ *    pose). The measured pose follows through a plant model: dead      *
+ *    time, first- or second-order lag, velocity and acceleration       *
+ *    limits. Without model options it follows instantly.               *
+ *  • Checks that each response echoes the IPOC of its packet and       *
+ *    arrives before the next packet is due. Like the real controller,  *
+ *    -s stops the robot after that many missed deadlines in a row.     *
+ *  • Reports round-trip percentiles, missed deadlines, tracking error  *
+ *    and settling time.                                                *
+ *  • Usage:  rsi_sim [-h host] [-p port] [-c 4|12] [-d seconds] [-A]   *
+ *                    [-t dead cycles] [-l tau ms] [-z damping]         *
+ *                    [-v max velocity] [-a max acceleration]           *
+ *                    [-s misses] [-e settle tolerance]                 *
+ *    Model values are one number for all axes or six, comma-separated, *
+ *    for X,Y,Z,A,B,C (mm, degrees, per s and s²). Value i also applies *
+ *    to joint A(i+1).                                                  *
+ *  • Exits with 1 on setup errors, 2 if any deadline was missed and 3  *
+ *    if the robot stopped.                                             *
+ *  • POSIX only.                                                       *
+ *---------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define TECH_PARAMETERS  10     /* Tech C11 .. C110 */
+#define PACKET_SIZE      2048
+#define AXES             12     /* X Y Z A B C, then A1 .. A6 */
+#define MAX_DEAD_CYCLES  250
+
+static const double START_POSE[AXES] = {
+    445.0, 0.0, 790.0, 180.0, 0.0, -180.0,      /* Cartesian */
+    0.0, -90.0, 90.0, 0.0, 90.0, 0.0            /* Joints */
+};
+
+static volatile sig_atomic_t g_exit = 0;
+static void on_signal(int sig) { (void)sig; g_exit = 1; }
+
+/*─ Plant model, per Cartesian axis; joint i uses the values of axis i ─*/
+typedef struct {
+    double tau_ms[6];           /* Lag time constant, 0 = none */
+    double zeta[6];             /* 0 = first-order lag, otherwise second order with ω = 1/tau */
+    double max_velocity[6];     /* Per s, 0 = unlimited */
+    double max_acceleration[6]; /* Per s², 0 = unlimited */
+    int    dead_cycles;         /* Cycles before a correction reaches the axes */
+    int    stop_after;          /* Missed deadlines in a row that stop the robot, 0 = never */
+    double settle_tolerance;    /* mm or degrees */
+} Model;
+
+/*─ Controller state ─*/
+typedef struct {
+    double   command[AXES];     /* Start pose plus corrections */
+    double   setpoint[AXES];    /* Command after the dead time (RSol, ASol) */
+    double   position[AXES];    /* Measured pose (RIst, AIPos) */
+    double   velocity[AXES];
+    double (*dead_line)[AXES];  /* Commands on their way to the axes */
+    uint64_t cycle;
+    uint32_t ipoc;
+    uint32_t cycle_ms;          /* IPOC step per packet */
+    uint64_t sent;
+    uint64_t on_time;           /* Right IPOC, before the next packet was due */
+    uint64_t missed;            /* No valid response before the next packet */
+    uint64_t late;              /* Echo of an earlier IPOC, after its deadline */
+    uint64_t bad_ipoc;          /* Response without the IPOC of any sent packet */
+    uint64_t longest_miss_run;
+    uint64_t miss_run;
+    bool     stopped;
+    double*  rtt_us;            /* Round trips of on-time responses */
+
+    double   error_sum_sq;      /* Tracking error |command - position| over X Y Z */
+    double   error_max;
+    double   previous_command[AXES];
+    bool     moving;            /* Commanded to move, settling not yet confirmed by the next move */
+    bool     in_band;           /* Within the settle tolerance of the command */
+    uint64_t move_start;
+    uint64_t settled_at;        /* Cycle the pose last entered the tolerance band */
+    uint64_t moves;             /* Moves that settled */
+    double   settle_sum_ms;
+    double   settle_max_ms;
+} Controller;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static struct timespec to_timespec(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+    return ts;
+}
+
+static double clamp(double value, double low, double high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+/*─ Packets ─*/
+static int format_axes(char* out, size_t size, const char* element, const char* const names[6],
+                       const double values[6]) {
+    return snprintf(out, size,
+                    "<%s %s=\"%.4f\" %s=\"%.4f\" %s=\"%.4f\" %s=\"%.4f\" %s=\"%.4f\" %s=\"%.4f\"/>",
+                    element, names[0], values[0], names[1], values[1], names[2], values[2],
+                    names[3], values[3], names[4], values[4], names[5], values[5]);
+}
+
+static const char* const CARTESIAN[6] = { "X", "Y", "Z", "A", "B", "C" };
+static const char* const JOINTS[6]    = { "A1", "A2", "A3", "A4", "A5", "A6" };
+
+static int build_packet(const Controller* robot, char* out, size_t size) {
+    int len = snprintf(out, size, "<Rob Type=\"KUKA\">");
+
+    len += format_axes(out + len, size - (size_t)len, "RIst", CARTESIAN, robot->position);
+    len += format_axes(out + len, size - (size_t)len, "RSol", CARTESIAN, robot->setpoint);
+    len += format_axes(out + len, size - (size_t)len, "AIPos", JOINTS, robot->position + 6);
+    len += format_axes(out + len, size - (size_t)len, "ASol", JOINTS, robot->setpoint + 6);
+    len += snprintf(out + len, size - (size_t)len, "<Delay D=\"%llu\"/><Tech",
+                    (unsigned long long)robot->missed);
+    for (int i = 1; i <= TECH_PARAMETERS; i++) {
+        len += snprintf(out + len, size - (size_t)len, " C1%d=\"0.0000\"", i);
+    }
+    len += snprintf(out + len, size - (size_t)len, "/><IPOC>%u</IPOC></Rob>", robot->ipoc);
+    return len;
+}
+
+/* Value of attribute `name` of the first <element ...> in the response */
+static bool find_attribute(const char* xml, const char* element, const char* name, double* value) {
+    char tag[32], key[16];
+    snprintf(tag, sizeof(tag), "<%s ", element);
+    snprintf(key, sizeof(key), " %s=\"", name);
+
+    const char* start = strstr(xml, tag);
+    if (!start) {
+        return false;
+    }
+    const char* end = strchr(start, '>');
+    const char* attr = strstr(start, key);
+    if (!attr || (end && attr > end)) {
+        return false;
+    }
+
+    char* parsed;
+    *value = strtod(attr + strlen(key), &parsed);
+    return parsed != attr + strlen(key);
+}
+
+static bool find_ipoc(const char* xml, uint32_t* ipoc) {
+    const char* start = strstr(xml, "<IPOC>");
+    char* parsed;
+
+    if (!start) {
+        return false;
+    }
+    unsigned long value = strtoul(start + 6, &parsed, 10);
+    if (parsed == start + 6 || strncmp(parsed, "</IPOC>", 7) != 0) {
+        return false;
+    }
+    *ipoc = (uint32_t)value;
+    return true;
+}
+
+static void apply_corrections(Controller* robot, const char* xml, bool absolute) {
+    double value;
+
+    for (int i = 0; i < 6; i++) {
+        if (find_attribute(xml, "RKorr", CARTESIAN[i], &value)) {
+            robot->command[i] = absolute ? START_POSE[i] + value : robot->command[i] + value;
+        }
+        if (find_attribute(xml, "AKorr", JOINTS[i], &value)) {
+            robot->command[i + 6] = absolute ? START_POSE[i + 6] + value : robot->command[i + 6] + value;
+        }
+    }
+}
+
+static bool was_sent(const Controller* robot, uint32_t ipoc) {
+    uint32_t age = robot->ipoc - ipoc;
+    return age % robot->cycle_ms == 0 && age / robot->cycle_ms < robot->sent;
+}
+
+/*─ Plant ─*/
+
+/* Exact response of x'' = -omega^2 x - 2 zeta omega x' over dt, stable for any tau */
+static void damped_step(double omega, double zeta, double dt, double* offset, double* velocity) {
+    double x0 = *offset;
+    double v0 = *velocity;
+
+    if (fabs(zeta - 1.0) < 1e-6) {
+        double decay = exp(-omega * dt);
+        double slope = v0 + omega * x0;
+        *offset   = decay * (x0 + slope * dt);
+        *velocity = decay * (v0 - omega * slope * dt);
+    } else if (zeta < 1.0) {
+        double sigma = zeta * omega;
+        double wd    = omega * sqrt(1.0 - zeta * zeta);
+        double decay = exp(-sigma * dt);
+        double c     = cos(wd * dt);
+        double s     = sin(wd * dt);
+        *offset   = decay * (x0 * c + (v0 + sigma * x0) / wd * s);
+        *velocity = decay * (v0 * c - (omega * omega * x0 + sigma * v0) / wd * s);
+    } else {
+        double root = omega * sqrt(zeta * zeta - 1.0);
+        double r1   = -zeta * omega + root;
+        double r2   = -zeta * omega - root;
+        double c1   = (v0 - r2 * x0) / (r1 - r2);
+        double c2   = x0 - c1;
+        *offset   = c1 * exp(r1 * dt) + c2 * exp(r2 * dt);
+        *velocity = r1 * c1 * exp(r1 * dt) + r2 * c2 * exp(r2 * dt);
+    }
+}
+
+static void step_axis(const Model* model, int parameter, double target, double* position,
+                      double* velocity, double dt) {
+    double tau  = model->tau_ms[parameter] / 1e3;
+    double zeta = model->zeta[parameter];
+    double vmax = model->max_velocity[parameter];
+    double amax = model->max_acceleration[parameter];
+    double error = target - *position;
+    double next;
+    double end_velocity;
+
+    // next is the mean velocity that reaches the exact position after one cycle
+    if (tau > 0.0 && zeta > 0.0) {
+        double offset = -error;
+        end_velocity = *velocity;
+        damped_step(1.0 / tau, zeta, dt, &offset, &end_velocity);
+        next = (offset + error) / dt;
+    } else {
+        // Exact step response of a first-order lag over one cycle
+        double alpha = tau > 0.0 ? 1.0 - exp(-dt / tau) : 1.0;
+        next = error * alpha / dt;
+        end_velocity = next;
+    }
+    double unlimited = next;
+
+    if (amax > 0.0) {
+        // Never faster than the axis can still stop at the target
+        double brake = sqrt(2.0 * amax * fabs(error));
+        next = clamp(next, -brake, brake);
+        next = clamp(next, *velocity - amax * dt, *velocity + amax * dt);
+    }
+    if (vmax > 0.0) {
+        next = clamp(next, -vmax, vmax);
+    }
+
+    *position += next * dt;
+    *velocity = next == unlimited ? end_velocity : next;
+}
+
+static void finish_move(Controller* robot) {
+    double settle_ms = (double)(robot->settled_at - robot->move_start) * robot->cycle_ms;
+
+    robot->moving = false;
+    robot->moves++;
+    robot->settle_sum_ms += settle_ms;
+    robot->settle_max_ms = fmax(robot->settle_max_ms, settle_ms);
+}
+
+/* Advance the robot by one cycle once its corrections are known */
+static void step_plant(Controller* robot, const Model* model) {
+    double   dt = robot->cycle_ms / 1e3;
+    uint64_t length = (uint64_t)model->dead_cycles + 1;
+    bool     changed = memcmp(robot->command, robot->previous_command, sizeof(robot->command)) != 0;
+
+    memcpy(robot->previous_command, robot->command, sizeof(robot->command));
+
+    // The oldest slot holds the command of dead_cycles cycles ago
+    memcpy(robot->dead_line[robot->cycle % length], robot->command, sizeof(robot->command));
+    memcpy(robot->setpoint, robot->dead_line[(robot->cycle + 1) % length], sizeof(robot->setpoint));
+
+    for (int i = 0; i < AXES; i++) {
+        step_axis(model, i % 6, robot->setpoint[i], &robot->position[i], &robot->velocity[i], dt);
+    }
+    robot->cycle++;
+
+    // Tracking error and settling against the command, so the dead time counts
+    double error = 0.0, worst = 0.0;
+    for (int i = 0; i < AXES; i++) {
+        double axis = robot->command[i] - robot->position[i];
+        if (i < 3) {
+            error += axis * axis;
+        }
+        worst = fmax(worst, fabs(axis));
+    }
+    robot->error_sum_sq += error;
+    robot->error_max = fmax(robot->error_max, sqrt(error));
+
+    // A move lasts from a command change until the pose stays within tolerance
+    if (changed) {
+        if (robot->moving && robot->in_band) {
+            finish_move(robot);
+        }
+        if (!robot->moving) {
+            robot->moving = true;
+            robot->in_band = false;
+            robot->move_start = robot->cycle;
+        }
+    }
+    bool in_band = worst <= model->settle_tolerance;
+    if (robot->moving && in_band && !robot->in_band) {
+        robot->settled_at = robot->cycle;
+    }
+    robot->in_band = in_band;
+}
+
+/*─ One cycle: send, then wait for the echo until the next packet is due ─*/
+static void run_cycle(Controller* robot, const Model* model, int sock,
+                      const struct sockaddr_in* addr, uint64_t deadline, bool absolute) {
+    char packet[PACKET_SIZE];
+    char response[PACKET_SIZE];
+    int  len = build_packet(robot, packet, sizeof(packet));
+
+    uint64_t sent = now_ns();
+    sendto(sock, packet, (size_t)len, 0, (const struct sockaddr*)addr, sizeof(*addr));
+    robot->sent++;
+
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= deadline || g_exit) {
+            break;
+        }
+
+        fd_set readable;
+        struct timespec timeout = to_timespec(deadline - now);
+        FD_ZERO(&readable);
+        FD_SET(sock, &readable);
+        if (pselect(sock + 1, &readable, NULL, NULL, &timeout, NULL) <= 0) {
+            continue;
+        }
+
+        ssize_t received = recv(sock, response, sizeof(response) - 1, 0);
+        uint64_t arrival = now_ns();
+        uint32_t ipoc;
+        if (received <= 0) {
+            continue;
+        }
+        response[received] = '\0';
+
+        if (!find_ipoc(response, &ipoc) || !was_sent(robot, ipoc)) {
+            robot->bad_ipoc++;
+        } else if (ipoc != robot->ipoc) {
+            robot->late++;
+        } else {
+            // A real controller ignores corrections that miss their cycle
+            apply_corrections(robot, response, absolute);
+            robot->rtt_us[robot->on_time++] = (double)(arrival - sent) / 1e3;
+            robot->miss_run = 0;
+            step_plant(robot, model);
+            return;
+        }
+    }
+
+    robot->missed++;
+    if (++robot->miss_run > robot->longest_miss_run) {
+        robot->longest_miss_run = robot->miss_run;
+    }
+    if (model->stop_after > 0 && robot->miss_run >= (uint64_t)model->stop_after) {
+        robot->stopped = true;
+    }
+    step_plant(robot, model);
+}
+
+/*─ Options ─*/
+/* One value for all axes, or six comma-separated values */
+static bool parse_axis_values(const char* text, double values[6]) {
+    int count = 0;
+    char* end;
+
+    for (;;) {
+        double value = strtod(text, &end);
+        if (end == text || value < 0.0 || count == 6) {
+            return false;
+        }
+        values[count++] = value;
+        if (*end != ',') {
+            break;
+        }
+        text = end + 1;
+    }
+    if (*end != '\0' || (count != 1 && count != 6)) {
+        return false;
+    }
+
+    for (int i = count; i < 6; i++) {
+        values[i] = values[0];
+    }
+    return true;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, uint64_t count, double p) {
+    return sorted[(uint64_t)(p * (double)(count - 1) + 0.5)];
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [-h host] [-p port] [-c 4|12] [-d seconds] [-A]\n"
+                    "       [-t dead cycles] [-l tau ms] [-z damping] [-v max velocity]\n"
+                    "       [-a max acceleration] [-s misses] [-e settle tolerance]\n"
+                    "model values: one for all axes or six for X,Y,Z,A,B,C\n", program);
+}
+
+int main(int argc, char** argv)
+{
+    const char* host     = "127.0.0.1";
+    int         port     = 59152;
+    int         cycle_ms = 4;
+    double      seconds  = 10.0;
+    bool        absolute = false;
+    bool        valid    = true;
+    Model       model;
+    int         opt;
+
+    memset(&model, 0, sizeof(model));
+    model.settle_tolerance = 0.01;
+
+    while ((opt = getopt(argc, argv, "h:p:c:d:At:l:z:v:a:s:e:")) != -1) {
+        switch (opt) {
+            case 'h': host = optarg; break;
+            case 'p': port = atoi(optarg); break;
+            case 'c': cycle_ms = atoi(optarg); break;
+            case 'd': seconds = atof(optarg); break;
+            case 'A': absolute = true; break;
+            case 't': model.dead_cycles = atoi(optarg); break;
+            case 'l': valid &= parse_axis_values(optarg, model.tau_ms); break;
+            case 'z': valid &= parse_axis_values(optarg, model.zeta); break;
+            case 'v': valid &= parse_axis_values(optarg, model.max_velocity); break;
+            case 'a': valid &= parse_axis_values(optarg, model.max_acceleration); break;
+            case 's': model.stop_after = atoi(optarg); break;
+            case 'e': model.settle_tolerance = atof(optarg); break;
+            default:  usage(argv[0]); return 1;
+        }
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons((uint16_t)port);
+    if (!valid || (cycle_ms != 4 && cycle_ms != 12) || seconds <= 0.0 || port <= 0 || port > 65535 ||
+        model.dead_cycles < 0 || model.dead_cycles > MAX_DEAD_CYCLES || model.stop_after < 0 ||
+        model.settle_tolerance <= 0.0 || inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    uint64_t cycle_ns = (uint64_t)cycle_ms * 1000000ULL;
+    uint64_t cycles   = (uint64_t)(seconds * 1e9 / (double)cycle_ns);
+    Controller robot;
+    memset(&robot, 0, sizeof(robot));
+    memcpy(robot.command, START_POSE, sizeof(robot.command));
+    memcpy(robot.setpoint, START_POSE, sizeof(robot.setpoint));
+    memcpy(robot.position, START_POSE, sizeof(robot.position));
+    memcpy(robot.previous_command, START_POSE, sizeof(robot.previous_command));
+    robot.ipoc      = (uint32_t)(now_ns() / 1000000ULL);
+    robot.cycle_ms  = (uint32_t)cycle_ms;
+    robot.rtt_us    = malloc((size_t)(cycles ? cycles : 1) * sizeof(double));
+    robot.dead_line = malloc((size_t)(model.dead_cycles + 1) * sizeof(*robot.dead_line));
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0 || !robot.rtt_us || !robot.dead_line) {
+        perror("rsi_sim");
+        return 1;
+    }
+    for (int i = 0; i <= model.dead_cycles; i++) {
+        memcpy(robot.dead_line[i], START_POSE, sizeof(START_POSE));
+    }
+
+    signal(SIGINT,  on_signal);
+    signal(SIGTERM, on_signal);
+
+    printf("rsi_sim: %s:%d, %d ms cycle, %.1f s, %s corrections\n",
+           host, port, cycle_ms, seconds, absolute ? "absolute" : "relative");
+    printf("model: dead time %d cycles, tau X %.1f ms, damping X %.2f, v max X %.1f, a max X %.1f, "
+           "stop after %d misses\n", model.dead_cycles, model.tau_ms[0], model.zeta[0],
+           model.max_velocity[0], model.max_acceleration[0], model.stop_after);
+
+    uint64_t next = now_ns();
+    for (uint64_t i = 0; i < cycles && !g_exit && !robot.stopped; i++) {
+        run_cycle(&robot, &model, sock, &addr, next + cycle_ns, absolute);
+
+        next += cycle_ns;
+        robot.ipoc += robot.cycle_ms;
+
+        struct timespec wake = to_timespec(next);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) != 0 && !g_exit) {
+        }
+    }
+    close(sock);
+
+    if (robot.stopped) {
+        printf("ROBOT STOPPED      after %llu missed deadlines in a row (IPOC %u)\n",
+               (unsigned long long)robot.miss_run, robot.ipoc - robot.cycle_ms);
+    }
+    printf("packets sent       %llu\n", (unsigned long long)robot.sent);
+    printf("responses on time  %llu\n", (unsigned long long)robot.on_time);
+    printf("missed deadlines   %llu (longest run %llu)\n",
+           (unsigned long long)robot.missed, (unsigned long long)robot.longest_miss_run);
+    printf("late responses     %llu\n", (unsigned long long)robot.late);
+    printf("wrong IPOC         %llu\n", (unsigned long long)robot.bad_ipoc);
+
+    if (robot.on_time > 0) {
+        qsort(robot.rtt_us, (size_t)robot.on_time, sizeof(double), compare_double);
+        printf("round trip us      p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+               percentile(robot.rtt_us, robot.on_time, 0.50),
+               percentile(robot.rtt_us, robot.on_time, 0.90),
+               percentile(robot.rtt_us, robot.on_time, 0.99),
+               percentile(robot.rtt_us, robot.on_time, 0.999),
+               robot.rtt_us[robot.on_time - 1]);
+    }
+    if (robot.cycle > 0) {
+        printf("tracking error mm  rms %.4f  max %.4f\n",
+               sqrt(robot.error_sum_sq / (double)robot.cycle), robot.error_max);
+    }
+    bool unsettled = robot.moving && !robot.in_band;
+    if (robot.moving && robot.in_band) {
+        finish_move(&robot);
+    }
+    if (robot.moves > 0) {
+        printf("settling ms        %llu moves, mean %.1f  max %.1f%s\n",
+               (unsigned long long)robot.moves, robot.settle_sum_ms / (double)robot.moves,
+               robot.settle_max_ms, unsettled ? ", last move not settled" : "");
+    } else if (unsettled) {
+        printf("settling ms        never settled\n");
+    }
+    printf("final RIst         X %.4f Y %.4f Z %.4f A %.4f B %.4f C %.4f\n",
+           robot.position[0], robot.position[1], robot.position[2],
+           robot.position[3], robot.position[4], robot.position[5]);
+
+    free(robot.dead_line);
+    free(robot.rtt_us);
+    return robot.stopped ? 3 : robot.missed > 0 ? 2 : 0;
+}
@@ -0,0 +1,73 @@
+/* rsi_telemetry.c – watch an RSI instance from another process
+ *---------------------------------------------------------------------*
+ *  • Attaches read-only to the shared-memory segment an instance       *
+ *    publishes with RSI_Config.telemetry_name, e.g. the monitor app.   *
+ *  • Prints position, packet counts and latency percentiles 10 times   *
+ *    a second until Ctrl-C or until the instance shuts down. A stuck   *
+ *    or crashed viewer cannot delay the robot loop.                    *
+ *  • Usage:  rsi_telemetry [segment name, default /rsi_monitor]        *
+ *---------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <signal.h>
+
+#ifdef _WIN32
+#   include <windows.h>
+#   define SLEEP_MS(ms)   Sleep(ms)
+#else
+#   include <unistd.h>
+#   define SLEEP_MS(ms)   usleep((ms) * 1000)
+#endif
+
+#include "kuka_rsi.h"
+
+static volatile bool g_exit = false;
+static void on_signal(int sig) { (void)sig; g_exit = true; }
+
+int main(int argc, char** argv)
+{
+    const char*           name = argc > 1 ? argv[1] : "/rsi_monitor";
+    RSI_TelemetryHandle   telemetry;
+    RSI_TelemetrySnapshot snap;
+
+    signal(SIGINT,  on_signal);
+    signal(SIGTERM, on_signal);
+
+    RSI_Error err = RSI_TelemetryOpen(name, &telemetry);
+    if (err != RSI_SUCCESS) {
+        fprintf(stderr, "%s: %s\n", name, err == RSI_ERROR_NOT_RUNNING
+                ? "no instance publishes telemetry under this name" : RSI_GetErrorString(err));
+        return 1;
+    }
+
+    while (!g_exit)
+    {
+        err = RSI_TelemetryRead(telemetry, &snap);
+        if (err != RSI_SUCCESS) {
+            printf("\n%s: %s\n", name, err == RSI_ERROR_NOT_RUNNING
+                   ? "instance shut down" : RSI_GetErrorString(err));
+            break;
+        }
+
+        const RSI_Statistics* st = &snap.frame.stats;
+        printf("pid %llu | IPOC %10u | %s | "
+               "XYZ %.1f %.1f %.1f mm | "
+               "rx %llu  late %llu  lost %llu | "
+               "response p50 %.3f p99 %.3f max %.3f ms | jitter p99 %.3f ms\r",
+               (unsigned long long)snap.owner_pid, snap.frame.ipoc,
+               st->is_connected ? "connected   " : "disconnected",
+               snap.frame.cartesian.x, snap.frame.cartesian.y, snap.frame.cartesian.z,
+               (unsigned long long)st->packets_received,
+               (unsigned long long)st->late_responses,
+               (unsigned long long)st->ipoc_missing_cycles,
+               snap.response_times.p50_ms, snap.response_times.p99_ms,
+               snap.response_times.max_ms, snap.jitter.p99_ms);
+        fflush(stdout);
+
+        SLEEP_MS(100);
+    }
+
+    RSI_TelemetryClose(telemetry);
+    return 0;
+}
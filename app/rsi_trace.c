@@ -0,0 +1,182 @@
+/* rsi_trace.c – decode a trace written by RSI_DumpTrace
+ *---------------------------------------------------------------------*
+ *  • Prints one line per event, with times relative to the first one.  *
+ *  • --json writes the Chrome trace event format instead; open it in   *
+ *    chrome://tracing or ui.perfetto.dev. Cycles and the time their    *
+ *    packet waited in the kernel show up as slices, everything else as *
+ *    instant events.                                                   *
+ *  • Usage:  rsi_trace [--json] trace-file                             *
+ *---------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kuka_rsi.h"
+
+static const char* const EVENT_NAMES[RSI_TRACE_EVENT_COUNT] = {
+    [RSI_TRACE_CYCLE]              = "cycle",
+    [RSI_TRACE_SLOW_RESPONSE]      = "slow response",
+    [RSI_TRACE_LATE_RESPONSE]      = "late response",
+    [RSI_TRACE_STALE_PACKETS]      = "stale packets",
+    [RSI_TRACE_IPOC_GAP]           = "ipoc gap",
+    [RSI_TRACE_IPOC_DUPLICATE]     = "ipoc duplicate",
+    [RSI_TRACE_IPOC_OUT_OF_ORDER]  = "ipoc out of order",
+    [RSI_TRACE_UNDERRUN]           = "underrun",
+    [RSI_TRACE_CONNECTED]          = "connected",
+    [RSI_TRACE_CONNECTION_TIMEOUT] = "connection timeout",
+    [RSI_TRACE_BAD_PACKET]         = "bad packet",
+};
+
+static const char* event_name(uint32_t event) {
+    return event < RSI_TRACE_EVENT_COUNT ? EVENT_NAMES[event] : "unknown";
+}
+
+static double ms(uint64_t ns) { return (double)ns / 1e6; }
+
+/*─ Loading ─*/
+static RSI_TraceRecord* load(const char* path, RSI_TraceHeader* header) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return NULL;
+    }
+
+    if (fread(header, sizeof(*header), 1, file) != 1 ||
+        memcmp(header->magic, RSI_TRACE_MAGIC, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "%s: not an RSI trace\n", path);
+        fclose(file);
+        return NULL;
+    }
+    if (header->version != RSI_TRACE_VERSION || header->record_size != sizeof(RSI_TraceRecord)) {
+        fprintf(stderr, "%s: trace version %u with %u byte records is not supported\n",
+                path, header->version, header->record_size);
+        fclose(file);
+        return NULL;
+    }
+
+    RSI_TraceRecord* records = malloc((size_t)(header->record_count ? header->record_count : 1) *
+                                      sizeof(RSI_TraceRecord));
+    if (!records ||
+        fread(records, sizeof(RSI_TraceRecord), (size_t)header->record_count, file) != header->record_count) {
+        fprintf(stderr, "%s: truncated trace\n", path);
+        free(records);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    return records;
+}
+
+/*─ Text ─*/
+static void print_details(const RSI_TraceRecord* r) {
+    switch (r->event) {
+        case RSI_TRACE_CYCLE:
+            printf("response %.3f ms", ms(r->args[0]));
+            if (r->args[1]) {
+                printf(", %.3f ms in the kernel", ms(r->args[1]));
+            }
+            break;
+        case RSI_TRACE_SLOW_RESPONSE:
+            printf("%.3f ms, cycle %.3f ms", ms(r->args[0]), ms(r->args[1]));
+            break;
+        case RSI_TRACE_LATE_RESPONSE:
+            printf("%.3f ms after kernel receive, %.3f ms before processing", ms(r->args[0]), ms(r->args[1]));
+            break;
+        case RSI_TRACE_STALE_PACKETS:
+            printf("%llu skipped", (unsigned long long)r->args[0]);
+            break;
+        case RSI_TRACE_IPOC_GAP:
+            printf("%llu missing after IPOC %llu",
+                   (unsigned long long)r->args[1], (unsigned long long)r->args[0]);
+            break;
+        case RSI_TRACE_IPOC_OUT_OF_ORDER:
+            printf("newest IPOC %llu", (unsigned long long)r->args[0]);
+            break;
+        case RSI_TRACE_CONNECTION_TIMEOUT:
+            printf("after %llu ms", (unsigned long long)r->args[0]);
+            break;
+        case RSI_TRACE_BAD_PACKET:
+            printf("%llu bytes", (unsigned long long)r->args[0]);
+            break;
+        default:
+            break;
+    }
+}
+
+static void print_text(const RSI_TraceHeader* header, const RSI_TraceRecord* records) {
+    uint64_t origin = header->record_count ? records[0].timestamp_ns : 0;
+
+    printf("# %llu events, %llu older events overwritten\n",
+           (unsigned long long)header->record_count, (unsigned long long)header->lost_records);
+    printf("# %12s  %10s  %-18s  %s\n", "time ms", "ipoc", "event", "details");
+
+    for (uint64_t i = 0; i < header->record_count; i++) {
+        const RSI_TraceRecord* r = &records[i];
+        printf("  %12.6f  %10u  %-18s  ",
+               (double)(int64_t)(r->timestamp_ns - origin) / 1e6, r->ipoc, event_name(r->event));
+        print_details(r);
+        putchar('\n');
+    }
+}
+
+/*─ Chrome trace JSON, timestamps in microseconds ─*/
+static void print_json(const RSI_TraceHeader* header, const RSI_TraceRecord* records) {
+    uint64_t origin = header->record_count ? records[0].timestamp_ns : 0;
+    const char* separator = "\n";
+
+    printf("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"lost_records\":%llu},\"traceEvents\":[",
+           (unsigned long long)header->lost_records);
+
+    for (uint64_t i = 0; i < header->record_count; i++) {
+        const RSI_TraceRecord* r = &records[i];
+        double ts = (double)(int64_t)(r->timestamp_ns - origin) / 1e3;
+
+        if (r->event == RSI_TRACE_CYCLE) {
+            if (r->args[1]) {
+                printf("%s{\"name\":\"kernel queue\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                       "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"ipoc\":%u}}",
+                       separator, ts - (double)r->args[1] / 1e3, (double)r->args[1] / 1e3, r->ipoc);
+                separator = ",\n";
+            }
+            printf("%s{\"name\":\"cycle\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                   "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"ipoc\":%u}}",
+                   separator, ts, (double)r->args[0] / 1e3, r->ipoc);
+        } else {
+            printf("%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":1,"
+                   "\"ts\":%.3f,\"args\":{\"ipoc\":%u,\"arg0\":%llu,\"arg1\":%llu}}",
+                   separator, event_name(r->event), ts, r->ipoc,
+                   (unsigned long long)r->args[0], (unsigned long long)r->args[1]);
+        }
+        separator = ",\n";
+    }
+
+    printf("\n]}\n");
+}
+
+int main(int argc, char** argv)
+{
+    int   json = argc == 3 && strcmp(argv[1], "--json") == 0;
+    const char* path = argv[argc - 1];
+    RSI_TraceHeader header;
+
+    if (argc != 2 + json) {
+        fprintf(stderr, "usage: %s [--json] trace-file\n", argv[0]);
+        return 1;
+    }
+
+    RSI_TraceRecord* records = load(path, &header);
+    if (!records) {
+        return 1;
+    }
+
+    if (json) {
+        print_json(&header, records);
+    } else {
+        print_text(&header, records);
+    }
+
+    free(records);
+    return 0;
+}
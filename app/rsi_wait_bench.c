@@ -0,0 +1,103 @@
+/* rsi_wait_bench.c – latency/CPU trade-off of the network wait strategies
+ *---------------------------------------------------------------------*
+ *  • Runs the library against a simulated robot on loopback that sends *
+ *    one packet every 4 ms, once per RSI_WaitStrategy.                 *
+ *  • Reports the robot-side round trip (p50 / p99 / max) of the        *
+ *    answers that carry the packet's IPOC and arrive within its cycle, *
+ *    and the CPU time the library burns, as a share of one core.       *
+ *  • Usage:  rsi_wait_bench [seconds per strategy] [port]              *
+ *  • POSIX only (uses pthreads and CLOCK_THREAD_CPUTIME_ID).           *
+ *---------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "kuka_rsi.h"
+#include "bench_common.h"
+
+#define MAX_SAMPLES  100000
+
+static const struct {
+    RSI_WaitStrategy strategy;
+    const char*      name;
+} STRATEGIES[] = {
+    { RSI_WAIT_BUSY_POLL, "busy-poll" },
+    { RSI_WAIT_BLOCKING,  "blocking"  },
+    { RSI_WAIT_EPOLL,     "epoll"     },
+    { RSI_WAIT_HYBRID,    "hybrid"    },
+};
+
+/*─ One strategy ─*/
+static void run_strategy(RSI_WaitStrategy strategy, const char* name,
+                         int seconds, uint16_t port, BenchRobot* robot) {
+    RSI_Config cfg = {0};
+    pthread_t  thread;
+
+    cfg.local_ip      = "127.0.0.1";
+    cfg.local_port    = port;
+    cfg.timeout_ms    = 1000;
+    cfg.wait_strategy = strategy;
+
+    if (RSI_Init(&cfg) != RSI_SUCCESS || RSI_Start() != RSI_SUCCESS) {
+        printf("%-10s  failed to start\n", name);
+        RSI_Cleanup();
+        return;
+    }
+
+    robot->port     = port;
+    robot->format   = TYPICAL_FORMAT;
+    robot->cycles   = seconds * (1000000 / CYCLE_US);
+    robot->answered = 0;
+
+    double wall_start = now_us(CLOCK_MONOTONIC);
+    double cpu_start  = now_us(CLOCK_PROCESS_CPUTIME_ID);
+
+    pthread_create(&thread, NULL, bench_robot_thread, robot);
+    pthread_join(thread, NULL);
+
+    double cpu_ms  = (now_us(CLOCK_PROCESS_CPUTIME_ID) - cpu_start) / 1e3 - robot->cpu_ms;
+    double wall_ms = (now_us(CLOCK_MONOTONIC) - wall_start) / 1e3;
+
+    RSI_Stop();
+    RSI_Cleanup();
+
+    if (robot->answered == 0) {
+        printf("%-10s  no responses\n", name);
+        return;
+    }
+
+    qsort(robot->rtt_us, (size_t)robot->answered, sizeof(double), compare_double);
+    printf("%-10s  %5d/%-5d  %8.1f  %8.1f  %8.1f  %6.1f%%\n",
+           name, robot->answered, robot->cycles,
+           robot->rtt_us[robot->answered / 2],
+           robot->rtt_us[(robot->answered * 99) / 100],
+           robot->rtt_us[robot->answered - 1],
+           100.0 * cpu_ms / wall_ms);
+}
+
+int main(int argc, char** argv)
+{
+    int      seconds = argc > 1 ? atoi(argv[1]) : 5;
+    uint16_t port    = argc > 2 ? (uint16_t)atoi(argv[2]) : 59152;
+    static double rtt_us[MAX_SAMPLES];
+    BenchRobot    robot = { .rtt_us = rtt_us };
+
+    if (seconds <= 0 || seconds * (1000000 / CYCLE_US) > MAX_SAMPLES) {
+        fprintf(stderr, "usage: %s [seconds per strategy, 1-%d] [port]\n",
+                argv[0], MAX_SAMPLES / (1000000 / CYCLE_US));
+        return 1;
+    }
+
+    printf("RSI wait strategies, %d s each, %d us cycle on loopback\n\n", seconds, CYCLE_US);
+    printf("%-10s  %11s  %8s  %8s  %8s  %7s\n",
+           "strategy", "responses", "p50 us", "p99 us", "max us", "cpu");
+
+    for (size_t i = 0; i < sizeof(STRATEGIES) / sizeof(STRATEGIES[0]); i++) {
+        run_strategy(STRATEGIES[i].strategy, STRATEGIES[i].name, seconds, port, &robot);
+    }
+
+    return 0;
+}
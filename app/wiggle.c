@@ -4,7 +4,7 @@
  *  • Captures start-of-program X and oscillates ±4 mm about it.        *
  *  • Sends a “pulse” pair each time:  ±0.05 mm   →   0 mm.             *
  *    └─ The zero on the second cycle prevents run-on after the step.   *
- *  • 12 ms cadence  →  ≈4 mm s-¹ feed rate.                            *
+ *  • Paced by RSI_WaitForCycle – sleeps until each robot packet.       *
  *  • Esc key (or Ctrl-C) aborts.                                       *
  *---------------------------------------------------------------------*/
 
@@ -91,10 +91,11 @@ int main(void)
     /*──────────────────── 2.  Motion parameters ───────────────*/
     const double STEP_MM   = 0.1;   /* one pulse = 0.05 mm */
     const double TRAVEL_MM = 1.0;    /* ±4 mm about start    */
-    const int    LOOP_MS   = 0;     /* ≈3 RSI cycles        */
     const double EPS_MM    = STEP_MM / 2.0;  /* flip buffer   */
 
     RSI_CartesianPosition pos  = {0};
+    RSI_Frame             frame;
+    uint32_t              last_ipoc = 0;
     RSI_CartesianCorrection corr, zero_corr;
     zero_correction(&corr);
     zero_correction(&zero_corr);
@@ -110,7 +111,10 @@ int main(void)
     /*──────────────────── 3.  Main loop ───────────────────────*/
     while (!g_exit) {
 
-        if (RSI_GetCartesianPosition(&pos) == RSI_SUCCESS) {
+        /* Blocks until the next robot packet instead of spinning */
+        if (RSI_WaitForCycle(last_ipoc, 100, &frame) == RSI_SUCCESS) {
+            pos       = frame.cartesian;
+            last_ipoc = frame.ipoc;
 
             if (isnan(start_x)) {            /* latch reference */
                 start_x     = pos.x;
@@ -155,8 +159,6 @@ int main(void)
             puts("\nEsc pressed – exiting.");
             g_exit = true;
         }
-
-        SLEEP_MS(LOOP_MS);
     }
 
     /*──────────────────── 4.  Shutdown ────────────────────────*/
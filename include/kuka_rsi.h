@@ -22,6 +22,7 @@
 #define KUKA_RSI_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 //C++ support
@@ -40,16 +41,77 @@ typedef enum {
     RSI_ERROR_THREAD_FAILED,   /**< Thread creation failed */
     RSI_ERROR_INVALID_PARAM,   /**< Invalid parameter provided */
     RSI_ERROR_TIMEOUT,         /**< Operation timed out */
+    RSI_ERROR_NOT_ENABLED,     /**< Feature not enabled in RSI_Config */
+    RSI_ERROR_NOT_SUPPORTED,   /**< Not supported on this platform */
+    RSI_ERROR_FILE_FAILED,     /**< File could not be written */
     RSI_ERROR_UNKNOWN          /**< Unknown error */
 } RSI_Error;
 
 
+//What the correction queue sends once it runs empty
+typedef enum {
+    RSI_UNDERRUN_HOLD = 0,     /**< Repeat the last correction sent */
+    RSI_UNDERRUN_ZERO,         /**< Send a zero correction */
+    RSI_UNDERRUN_DECAY         /**< Scale the last correction down every cycle */
+} RSI_UnderrunMode;
+
+
+//How the network thread waits for the next robot packet
+typedef enum {
+    RSI_WAIT_BUSY_POLL = 0,    /**< Spin on a non-blocking socket (lowest latency, one full core) */
+    RSI_WAIT_BLOCKING,         /**< Blocking receive, optionally with SO_BUSY_POLL (Linux) */
+    RSI_WAIT_EPOLL,            /**< Sleep in epoll_wait (Linux) or poll until readable */
+    RSI_WAIT_HYBRID            /**< Sleep until shortly before the predicted packet, then spin */
+} RSI_WaitStrategy;
+
+
+//Scheduling policy of the network thread
+typedef enum {
+    RSI_SCHED_FIFO = 0,        /**< SCHED_FIFO (time-critical priority on Windows) */
+    RSI_SCHED_RR,              /**< SCHED_RR (time-critical priority on Windows) */
+    RSI_SCHED_DEADLINE,        /**< SCHED_DEADLINE with the configured runtime and period (Linux only;
+                                    with cpu_mask, the CPUs must form an exclusive cpuset) */
+    RSI_SCHED_OTHER            /**< Leave the thread at normal priority */
+} RSI_SchedPolicy;
+
+
+//Stages of one cycle, see RSI_GetStagePercentiles
+typedef enum {
+    RSI_STAGE_RECEIVE = 0,     /**< Receive call that returned the packet */
+    RSI_STAGE_IPOC,            /**< Tokenize the datagram, extract and check the IPOC */
+    RSI_STAGE_PARSE,           /**< Parse RIst and AIPos */
+    RSI_STAGE_CORRECTION,      /**< Fetch the correction rendered by the application */
+    RSI_STAGE_FORMAT,          /**< Splice the IPOC into the response */
+    RSI_STAGE_CALLBACK,        /**< Data callback */
+    RSI_STAGE_SEND,            /**< sendto (and the send timestamp with kernel_timestamps) */
+    RSI_STAGE_COUNT            /**< Number of stages */
+} RSI_Stage;
+
+
 //@brief RSI connection configuration
 typedef struct {
     const char* local_ip;      /**< Local IP address (0.0.0.0 for any) */
     uint16_t local_port;       /**< Local port to bind to (default: 59152) */
     uint32_t timeout_ms;       /**< Connection timeout in milliseconds (0 for no timeout) */
     bool verbose;              /**< Enable verbose logging */
+    uint32_t sample_ring_size; /**< Per-cycle samples kept for RSI_ReadSamples (0 disables) */
+    uint32_t correction_queue_size; /**< Corrections buffered by RSI_QueueCorrections (0 disables) */
+    RSI_UnderrunMode underrun_mode; /**< Behavior when the correction queue runs empty */
+    double underrun_decay;     /**< Per-cycle factor for RSI_UNDERRUN_DECAY, in [0, 1) (0 for 0.9) */
+    RSI_WaitStrategy wait_strategy; /**< How the network thread waits for packets */
+    uint32_t busy_poll_us;     /**< SO_BUSY_POLL budget in microseconds (0 for off, Linux only) */
+    uint32_t hybrid_spin_us;   /**< RSI_WAIT_HYBRID spin window around the predicted packet (0 for 500) */
+    bool kernel_timestamps;    /**< Measure latency from kernel receive timestamps (POSIX only) */
+    uint64_t cpu_mask;         /**< CPUs the network thread may run on, bit n for CPU n (0 for no pinning) */
+    RSI_SchedPolicy sched_policy; /**< Scheduling policy of the network thread */
+    uint32_t sched_priority;   /**< RSI_SCHED_FIFO / RSI_SCHED_RR priority, 1-99 (0 for the maximum) */
+    uint32_t deadline_runtime_us; /**< RSI_SCHED_DEADLINE runtime per period (0 for 1000) */
+    uint32_t deadline_period_us; /**< RSI_SCHED_DEADLINE period and deadline (0 for 4000) */
+    bool lock_memory;          /**< mlockall(MCL_CURRENT | MCL_FUTURE) the process (POSIX only) */
+    uint32_t prefault_stack_kb; /**< Stack the network thread touches before its first packet, at most 512 (0 for none) */
+    bool stage_timing;         /**< Time every stage of each cycle for RSI_GetStagePercentiles */
+    uint32_t trace_records;    /**< Events kept by the trace ring for RSI_DumpTrace (0 for 4096) */
+    const char* telemetry_name; /**< Shared-memory segment to publish to, e.g. "/rsi_cell1" (NULL disables) */
 } RSI_Config;
 
 //Robot position in Cartesian coordinates
@@ -88,16 +150,134 @@ typedef struct {
 //Statistics about RSI communication
 typedef struct {
     uint64_t packets_received;           /**< Total packets received */
+    uint64_t stale_packets_dropped;      /**< Queued packets skipped because one with a newer IPOC was waiting */
     uint64_t packets_sent;               /**< Total packets sent */
-    double avg_response_time_ms;         /**< Average response time in ms */
-    double min_response_time_ms;         /**< Minimum response time in ms */
-    double max_response_time_ms;         /**< Maximum response time in ms */
-    uint64_t late_responses;             /**< Number of responses over 4ms */
+    double avg_response_time_ms;         /**< Average response time in ms (in user space) */
+    double min_response_time_ms;         /**< Minimum response time in ms (in user space) */
+    double max_response_time_ms;         /**< Maximum response time in ms (in user space) */
+    uint64_t late_responses;             /**< Number of responses over one robot cycle (in user space) */
     uint64_t connection_lost_count;      /**< Number of connection losses */
     bool is_connected;                   /**< Current connection status */
     uint64_t last_packet_timestamp_us;   /**< Timestamp of last packet */
+    uint64_t samples_dropped;            /**< Samples lost because the sample ring was full */
+    uint64_t corrections_played;         /**< Queued corrections sent to the robot */
+    uint64_t correction_underruns;       /**< Times the correction queue ran empty while streaming */
+    uint32_t correction_queue_depth;     /**< Corrections waiting in the queue */
+    bool kernel_timestamps;              /**< Kernel receive timestamps are being received */
+    double avg_e2e_response_time_ms;     /**< Average time from kernel receive to send completion in ms */
+    double min_e2e_response_time_ms;     /**< Minimum time from kernel receive to send completion in ms */
+    double max_e2e_response_time_ms;     /**< Maximum time from kernel receive to send completion in ms */
+    uint64_t late_e2e_responses;         /**< Number of responses over one robot cycle after kernel receive */
+    double avg_receive_delay_ms;         /**< Average time from kernel receive to start of processing in ms */
+    double max_receive_delay_ms;         /**< Maximum time from kernel receive to start of processing in ms */
+    double p50_response_time_ms;         /**< Median response time in ms (RSI_GetStatistics only) */
+    double p99_response_time_ms;         /**< 99th percentile response time in ms (RSI_GetStatistics only) */
+    double p999_response_time_ms;        /**< 99.9th percentile response time in ms (RSI_GetStatistics only) */
+    double robot_cycle_ms;               /**< Measured time between robot packets in ms, 0 until known */
+    uint32_t ipoc_increment;             /**< IPOC step per robot cycle, 0 until known */
+    double max_jitter_ms;                /**< Largest deviation of a packet from its expected arrival in ms */
+    double p50_jitter_ms;                /**< Median arrival jitter in ms (RSI_GetStatistics only) */
+    double p99_jitter_ms;                /**< 99th percentile arrival jitter in ms (RSI_GetStatistics only) */
+    double p999_jitter_ms;               /**< 99.9th percentile arrival jitter in ms (RSI_GetStatistics only) */
+    uint64_t ipoc_missing_cycles;        /**< Robot cycles whose packet never arrived */
+    uint32_t ipoc_longest_gap;           /**< Most consecutive robot cycles missing */
+    uint64_t ipoc_duplicates;            /**< Packets repeating the newest IPOC */
+    uint64_t ipoc_out_of_order;          /**< Packets older than the newest IPOC */
 } RSI_Statistics;
 
+//Percentiles of a latency histogram in ms, see RSI_GetPercentiles
+typedef struct {
+    uint64_t count;                      /**< Values counted */
+    double min_ms;                       /**< Smallest value */
+    double p50_ms;                       /**< Median */
+    double p90_ms;                       /**< 90th percentile */
+    double p99_ms;                       /**< 99th percentile */
+    double p999_ms;                      /**< 99.9th percentile */
+    double p9999_ms;                     /**< 99.99th percentile */
+    double max_ms;                       /**< Largest value */
+} RSI_Percentiles;
+
+//Record of one RSI cycle, see RSI_ReadSamples
+typedef struct {
+    uint32_t ipoc;                       /**< IPOC value from robot */
+    uint64_t receive_time_us;            /**< Timestamp when the packet was received */
+    uint64_t send_time_us;               /**< Timestamp when the response was sent */
+    uint32_t receive_delay_us;           /**< Kernel receive to start of processing (0 without kernel timestamps) */
+    double cartesian[6];                 /**< RIst X, Y, Z (mm), A, B, C (degrees) */
+    double joints[6];                    /**< AIPos A1-A6 in degrees */
+    RSI_CartesianCorrection correction;  /**< Correction sent in the response */
+} RSI_Sample;
+
+//Outcome of one real-time setup step, see RSI_GetStartupDiagnostics
+typedef struct {
+    RSI_Error status;          /**< RSI_SUCCESS, RSI_ERROR_NOT_ENABLED if not configured,
+                                    RSI_ERROR_NOT_SUPPORTED on this platform,
+                                    RSI_ERROR_INIT_FAILED if the system refused */
+    int os_error;              /**< errno (GetLastError() on Windows) if the system refused, 0 otherwise */
+} RSI_SetupResult;
+
+//Real-time setup of the process and network thread
+typedef struct {
+    RSI_SetupResult memory_lock;   /**< RSI_Config.lock_memory, applied by RSI_Init */
+    RSI_SetupResult affinity;      /**< RSI_Config.cpu_mask */
+    RSI_SetupResult scheduling;    /**< RSI_Config.sched_policy and priority */
+    RSI_SetupResult stack_prefault; /**< RSI_Config.prefault_stack_kb */
+    int cpu;                       /**< CPU the network thread started on, -1 if unknown */
+} RSI_StartupDiagnostics;
+
+//Robot cycles missing between two packets, see RSI_SetGapCallback
+typedef struct {
+    uint32_t last_ipoc;                  /**< Newest IPOC before the gap */
+    uint32_t ipoc;                       /**< IPOC of the packet after the gap */
+    uint32_t missing_cycles;             /**< Robot cycles without a packet */
+    uint64_t timestamp_us;               /**< When the packet after the gap was received */
+} RSI_IpocGap;
+
+//Events of the trace ring, see RSI_DumpTrace. Times and durations in ns.
+typedef enum {
+    RSI_TRACE_CYCLE = 0,           /**< Packet answered; args: response time, kernel receive delay (0 if unknown) */
+    RSI_TRACE_SLOW_RESPONSE,       /**< Response slower than one robot cycle; args: response time, cycle */
+    RSI_TRACE_LATE_RESPONSE,       /**< Kernel receive to send longer than one cycle; args: that time, receive delay */
+    RSI_TRACE_STALE_PACKETS,       /**< Datagrams skipped for one with a newer IPOC; args: count */
+    RSI_TRACE_IPOC_GAP,            /**< Robot cycles without a packet; args: previous IPOC, missing cycles */
+    RSI_TRACE_IPOC_DUPLICATE,      /**< IPOC received twice */
+    RSI_TRACE_IPOC_OUT_OF_ORDER,   /**< IPOC older than the newest; args: newest IPOC */
+    RSI_TRACE_UNDERRUN,            /**< Correction queue ran empty */
+    RSI_TRACE_CONNECTED,           /**< First packet of a connection */
+    RSI_TRACE_CONNECTION_TIMEOUT,  /**< No packet for timeout_ms; args: timeout_ms */
+    RSI_TRACE_BAD_PACKET,          /**< Datagram without a readable IPOC; args: length */
+    RSI_TRACE_EVENT_COUNT          /**< Number of events */
+} RSI_TraceEvent;
+
+//One event of the trace ring
+typedef struct {
+    uint64_t timestamp_ns;               /**< Time of the event, on the clock of the sample timestamps */
+    uint32_t event;                      /**< RSI_TraceEvent */
+    uint32_t ipoc;                       /**< IPOC of the packet (0 if none) */
+    uint64_t args[2];                    /**< Event arguments, see RSI_TraceEvent */
+} RSI_TraceRecord;
+
+//Trace file written by RSI_DumpTrace: this header, then the records oldest first,
+//in the byte order of the machine that wrote it
+#define RSI_TRACE_MAGIC "RSITRACE"
+#define RSI_TRACE_VERSION 1
+
+typedef struct {
+    char magic[8];                       /**< RSI_TRACE_MAGIC without the terminator */
+    uint32_t version;                    /**< RSI_TRACE_VERSION */
+    uint32_t record_size;                /**< sizeof(RSI_TraceRecord) */
+    uint64_t record_count;               /**< Records in the file */
+    uint64_t lost_records;               /**< Older records already overwritten */
+} RSI_TraceHeader;
+
+//Complete robot state of one cycle
+typedef struct {
+    RSI_CartesianPosition cartesian;     /**< Cartesian position */
+    RSI_JointPosition joints;            /**< Joint position */
+    uint32_t ipoc;                       /**< IPOC value of the cycle */
+    RSI_Statistics stats;                /**< Statistics including this cycle */
+} RSI_Frame;
+
 /**
  * @brief Callback for robot data
  * 
@@ -122,6 +302,18 @@ typedef void (*RSI_DataCallback)(const RSI_CartesianPosition* cartesian,
  */
 typedef void (*RSI_ConnectionCallback)(bool connected, void* user_data);
 
+/**
+ * @brief Callback for missing robot cycles
+ * 
+ * This callback is called once for every gap in the IPOC sequence. It runs
+ * in a separate thread at normal priority, shortly after the packet that
+ * revealed the gap was answered, so it may block or log.
+ * 
+ * @param gap The gap
+ * @param user_data User data pointer provided in RSI_SetGapCallback
+ */
+typedef void (*RSI_GapCallback)(const RSI_IpocGap* gap, void* user_data);
+
 /**
  * @brief Initialize the RSI library
  * 
@@ -145,6 +337,20 @@ RSI_Error RSI_SetCallbacks(RSI_DataCallback data_callback,
                           RSI_ConnectionCallback connection_callback,
                           void* user_data);
 
+/**
+ * @brief Set the callback for missing robot cycles
+ * 
+ * Must be called before RSI_Start(). The network thread only queues each
+ * gap; a helper thread started by RSI_Start() calls the callback. If the
+ * callback falls more than 64 gaps behind, further gaps are not reported,
+ * but they are still counted in RSI_Statistics.
+ * 
+ * @param gap_callback Callback for gaps (NULL to disable)
+ * @param user_data User data pointer passed to the callback
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_SetGapCallback(RSI_GapCallback gap_callback, void* user_data);
+
 /**
  * @brief Start RSI communication
  * 
@@ -194,12 +400,42 @@ RSI_Error RSI_GetJointPosition(RSI_JointPosition* position);
  * @brief Send Cartesian correction to the robot
  * 
  * This function sets the correction values to be sent in the next response.
+ * The response packet is rendered here, on the calling thread, so the
+ * network thread only has to insert the IPOC when a packet arrives.
  * 
  * @param correction Correction values
  * @return RSI_SUCCESS on success, error code otherwise
  */
 RSI_Error RSI_SetCartesianCorrection(const RSI_CartesianCorrection* correction);
 
+/**
+ * @brief Queue corrections to be sent one per robot cycle
+ * 
+ * Requires RSI_Config.correction_queue_size > 0. Each queued correction is
+ * sent in exactly one response, in order, so a pre-planned trajectory can be
+ * streamed ahead of time without matching the robot cycle from the
+ * application. Responses are rendered here, on the calling thread. When the
+ * queue runs empty, RSI_Config.underrun_mode decides what is sent; with
+ * RSI_UNDERRUN_HOLD and RSI_UNDERRUN_DECAY, a correction set with
+ * RSI_SetCartesianCorrection() replaces the last queued one.
+ * 
+ * @param corrections Array of corrections, oldest first
+ * @param count Number of corrections in the array
+ * @param queued Receives how many were queued (fewer than count if the queue is full)
+ * @return RSI_SUCCESS on success, RSI_ERROR_NOT_ENABLED if the queue is disabled
+ */
+RSI_Error RSI_QueueCorrections(const RSI_CartesianCorrection* corrections, size_t count, size_t* queued);
+
+/**
+ * @brief Discard all queued corrections
+ * 
+ * Corrections queued before this call are never sent. The underrun policy
+ * applies from the next cycle unless new corrections are queued.
+ * 
+ * @return RSI_SUCCESS on success, RSI_ERROR_NOT_ENABLED if the queue is disabled
+ */
+RSI_Error RSI_FlushCorrections(void);
+
 /**
  * @brief Get statistics about RSI communication
  * 
@@ -208,6 +444,354 @@ RSI_Error RSI_SetCartesianCorrection(const RSI_CartesianCorrection* correction);
  */
 RSI_Error RSI_GetStatistics(RSI_Statistics* stats);
 
+/**
+ * @brief Get response time percentiles since RSI_Init()
+ * 
+ * Every response time (in user space, as in RSI_Statistics) is counted in
+ * a fixed-size log-linear histogram. The network thread records each
+ * value with a single increment and never waits for readers. Values are
+ * rounded up to their bucket, which is at most 1/64 (1.6%) wide, so
+ * percentiles are never understated.
+ * 
+ * @param percentiles Pointer to structure to receive the percentiles
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_GetPercentiles(RSI_Percentiles* percentiles);
+
+/**
+ * @brief Get response time percentiles since the last window reset
+ * 
+ * Like RSI_GetPercentiles(), but only over the responses since the last
+ * call with reset set to true (or since RSI_Init()). Use it for periodic
+ * reports and regression gates where one old outlier must not dominate.
+ * Resetting does not touch the histogram the network thread writes.
+ * 
+ * @param reset Start a new window after reading this one
+ * @param percentiles Pointer to structure to receive the percentiles
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_GetWindowPercentiles(bool reset, RSI_Percentiles* percentiles);
+
+/**
+ * @brief Get arrival jitter percentiles since RSI_Init()
+ * 
+ * The jitter of a robot packet is how far its arrival deviates from the
+ * arrival of the previous packet plus the measured robot cycle (times the
+ * number of cycles from the IPOC step). The kernel receive timestamp is
+ * used when RSI_Config.kernel_timestamps is set, so scheduling of the
+ * network thread does not add to it.
+ * 
+ * @param percentiles Pointer to structure to receive the percentiles
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_GetJitterPercentiles(RSI_Percentiles* percentiles);
+
+/**
+ * @brief Get the percentiles of one stage of the cycle since RSI_Init()
+ * 
+ * Requires RSI_Config.stage_timing. The network thread reads a tick
+ * counter at every stage boundary (the invariant TSC on x86, the virtual
+ * counter on ARM64) and counts each stage in its own histogram, so a
+ * regression in the response time can be traced to the stage that grew.
+ * The stages from RSI_STAGE_IPOC to RSI_STAGE_SEND add up to the response
+ * time. RSI_STAGE_RECEIVE is measured separately; with RSI_WAIT_BLOCKING
+ * it includes the wait for the packet.
+ * 
+ * @param stage Stage to report
+ * @param percentiles Pointer to structure to receive the percentiles
+ * @return RSI_SUCCESS on success, RSI_ERROR_NOT_ENABLED if stage timing is off
+ */
+RSI_Error RSI_GetStagePercentiles(RSI_Stage stage, RSI_Percentiles* percentiles);
+
+/**
+ * @brief Get the latest robot state as one consistent frame
+ * 
+ * Unlike calling RSI_GetCartesianPosition(), RSI_GetJointPosition() and
+ * RSI_GetStatistics() in a row, all fields are guaranteed to come from the
+ * same cycle. Never blocks the network thread.
+ * 
+ * @param frame Pointer to structure to receive the frame
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_GetFrame(RSI_Frame* frame);
+
+/**
+ * @brief Wait for the next robot cycle
+ * 
+ * Blocks until a frame with an IPOC different from last_ipoc is published,
+ * then returns it like RSI_GetFrame(). The caller sleeps in the kernel
+ * (futex on Linux) instead of polling, and is woken right after the
+ * network thread has sent its response. Pass the IPOC of the previous frame
+ * to wait for the next one; pass 0 to get the current frame if a packet
+ * has already been received.
+ * 
+ * @param last_ipoc IPOC of the last frame the caller has seen
+ * @param timeout_ms Maximum time to wait in milliseconds (0 to only check)
+ * @param frame Pointer to structure to receive the frame
+ * @return RSI_SUCCESS on a new frame, RSI_ERROR_TIMEOUT if none arrived in
+ *         time, RSI_ERROR_NOT_RUNNING if RSI is (or gets) stopped
+ */
+RSI_Error RSI_WaitForCycle(uint32_t last_ipoc, uint32_t timeout_ms, RSI_Frame* frame);
+
+/**
+ * @brief Get a file descriptor that becomes readable after every cycle
+ * 
+ * Linux only. Returns an eventfd that the network thread signals after
+ * each response, for applications built around epoll, poll or select.
+ * Reading it resets the counter to zero. Call RSI_GetFrame() to get the
+ * data of the cycle. The descriptor is owned by the library and closed by
+ * RSI_Cleanup().
+ * 
+ * @param fd Receives the file descriptor
+ * @return RSI_SUCCESS on success, RSI_ERROR_NOT_SUPPORTED on other platforms
+ */
+RSI_Error RSI_GetEventFd(int* fd);
+
+/**
+ * @brief Get the outcome of the real-time setup
+ * 
+ * Memory locking is applied by RSI_Init(); CPU pinning, the scheduling
+ * policy and stack prefaulting are applied by the network thread before
+ * RSI_Start() returns. A step the system refused does not stop the
+ * library, but it is a likely source of late responses, so check this
+ * after RSI_Start(). With RSI_Config.verbose, failures are also printed.
+ * 
+ * @param diagnostics Pointer to structure to receive the results
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_GetStartupDiagnostics(RSI_StartupDiagnostics* diagnostics);
+
+/**
+ * @brief Drain per-cycle samples recorded by the network thread
+ * 
+ * Requires RSI_Config.sample_ring_size > 0. Every processed packet leaves
+ * one sample in a lock-free ring, so a consumer that is slower than the
+ * robot cycle still sees every cycle as long as it keeps up on average.
+ * When the ring is full, new samples are dropped and counted in
+ * RSI_Statistics.samples_dropped. Samples must be drained from a single
+ * thread.
+ * 
+ * @param samples Array to receive the oldest samples
+ * @param max_samples Capacity of the array
+ * @param count Receives the number of samples written
+ * @return RSI_SUCCESS on success, RSI_ERROR_NOT_ENABLED if the ring is disabled
+ */
+RSI_Error RSI_ReadSamples(RSI_Sample* samples, size_t max_samples, size_t* count);
+
+/**
+ * @brief Write the trace ring to a file
+ * 
+ * The network thread records every cycle and every irregularity (slow
+ * responses, IPOC gaps, timeouts, ...) in a fixed ring of binary records
+ * that always holds the newest RSI_Config.trace_records events. Recording
+ * takes no lock and no system call, so tracing is always on. This copies
+ * the ring without stopping the network thread, while running or after
+ * RSI_Stop(), and writes it as an RSI_TraceHeader followed by the records.
+ * The rsi_trace tool prints the file as text or Chrome trace JSON.
+ * 
+ * @param path File to create or overwrite
+ * @return RSI_SUCCESS on success, RSI_ERROR_FILE_FAILED if the file cannot be written
+ */
+RSI_Error RSI_DumpTrace(const char* path);
+
+/**
+ * @brief Handle to an independent RSI instance
+ * 
+ * The functions above operate on a single default instance. To serve several
+ * robots from one process, create one instance per robot with RSI_Create()
+ * and use the functions ending in H. Every instance has its own socket,
+ * network thread, statistics and queues; instances share no state, so
+ * different instances may be driven from different threads.
+ */
+typedef struct RSI_Context* RSI_Handle;
+
+/**
+ * @brief Create and initialize a new RSI instance
+ * 
+ * Equivalent to RSI_Init() for a new instance. Each instance needs its own
+ * RSI_Config.local_port.
+ * 
+ * @param config Configuration parameters (or NULL for defaults)
+ * @param handle Receives the new instance
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_Create(const RSI_Config* config, RSI_Handle* handle);
+
+/**
+ * @brief Stop, clean up and free an instance created with RSI_Create()
+ * 
+ * @param handle Instance to destroy; invalid after this call
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_Destroy(RSI_Handle handle);
+
+/* Same as the functions without the H suffix, on the given instance */
+RSI_Error RSI_SetCallbacksH(RSI_Handle handle,
+                           RSI_DataCallback data_callback,
+                           RSI_ConnectionCallback connection_callback,
+                           void* user_data);
+RSI_Error RSI_SetGapCallbackH(RSI_Handle handle, RSI_GapCallback gap_callback, void* user_data);
+RSI_Error RSI_StartH(RSI_Handle handle);
+RSI_Error RSI_StopH(RSI_Handle handle);
+RSI_Error RSI_GetCartesianPositionH(RSI_Handle handle, RSI_CartesianPosition* position);
+RSI_Error RSI_GetJointPositionH(RSI_Handle handle, RSI_JointPosition* position);
+RSI_Error RSI_SetCartesianCorrectionH(RSI_Handle handle, const RSI_CartesianCorrection* correction);
+RSI_Error RSI_QueueCorrectionsH(RSI_Handle handle, const RSI_CartesianCorrection* corrections,
+                               size_t count, size_t* queued);
+RSI_Error RSI_FlushCorrectionsH(RSI_Handle handle);
+RSI_Error RSI_GetStatisticsH(RSI_Handle handle, RSI_Statistics* stats);
+RSI_Error RSI_GetPercentilesH(RSI_Handle handle, RSI_Percentiles* percentiles);
+RSI_Error RSI_GetWindowPercentilesH(RSI_Handle handle, bool reset, RSI_Percentiles* percentiles);
+RSI_Error RSI_GetJitterPercentilesH(RSI_Handle handle, RSI_Percentiles* percentiles);
+RSI_Error RSI_GetStagePercentilesH(RSI_Handle handle, RSI_Stage stage, RSI_Percentiles* percentiles);
+RSI_Error RSI_GetFrameH(RSI_Handle handle, RSI_Frame* frame);
+RSI_Error RSI_WaitForCycleH(RSI_Handle handle, uint32_t last_ipoc, uint32_t timeout_ms, RSI_Frame* frame);
+RSI_Error RSI_GetEventFdH(RSI_Handle handle, int* fd);
+RSI_Error RSI_GetStartupDiagnosticsH(RSI_Handle handle, RSI_StartupDiagnostics* diagnostics);
+RSI_Error RSI_ReadSamplesH(RSI_Handle handle, RSI_Sample* samples, size_t max_samples, size_t* count);
+RSI_Error RSI_DumpTraceH(RSI_Handle handle, const char* path);
+
+/**
+ * @brief Handle to an event-loop server for many instances
+ * 
+ * Instead of one network thread per instance, a server drives any number of
+ * instances from a few event-loop threads. Each thread sleeps in epoll_wait
+ * (Linux) or poll on the sockets of its share of the robots and answers
+ * whichever robot is ready. Use this for test benches with dozens of
+ * virtual controllers; a single robot gets the lowest latency from its own
+ * network thread.
+ */
+typedef struct RSI_Server* RSI_ServerHandle;
+
+//Event-loop server configuration
+typedef struct {
+    uint32_t thread_count;     /**< Event-loop threads (0 for 1, at most 64, capped at the robot count) */
+    const int* cpus;           /**< CPU (0-63) to pin each thread to, thread_count entries, -1 for unpinned (NULL for none) */
+    RSI_SchedPolicy sched_policy; /**< Scheduling of the event-loop threads (default RSI_SCHED_FIFO; RSI_SCHED_DEADLINE is not supported) */
+    uint32_t sched_priority;   /**< RSI_SCHED_FIFO / RSI_SCHED_RR priority, 1-99 (0 for the maximum) */
+    bool verbose;              /**< Enable verbose logging */
+} RSI_ServerConfig;
+
+/**
+ * @brief Create an event-loop server
+ * 
+ * @param config Server configuration (or NULL for one unpinned thread)
+ * @param handle Receives the new server
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_ServerCreate(const RSI_ServerConfig* config, RSI_ServerHandle* handle);
+
+/**
+ * @brief Attach an instance to a server
+ * 
+ * The instance must be created with RSI_Create() and not be running.
+ * Instances are dealt round-robin over the event-loop threads in the order
+ * they are added. Once attached, the instance is started and stopped with
+ * the server; RSI_StartH() and RSI_StopH() return RSI_ERROR_INVALID_PARAM.
+ * All other functions work as usual. RSI_Config.wait_strategy and the
+ * network thread settings (cpu_mask, sched_*, prefault_stack_kb) are ignored;
+ * the server's cpus and sched_* settings apply instead.
+ * 
+ * @param server Server that drives the instance
+ * @param handle Instance to attach
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_ServerAdd(RSI_ServerHandle server, RSI_Handle handle);
+
+/**
+ * @brief Bind all attached instances and start the event-loop threads
+ * 
+ * @param server Server to start
+ * @return RSI_SUCCESS on success, error code otherwise (nothing is left running)
+ */
+RSI_Error RSI_ServerStart(RSI_ServerHandle server);
+
+/**
+ * @brief Get the real-time setup of one event-loop thread
+ * 
+ * Like RSI_GetStartupDiagnosticsH() for an instance, filled in by each
+ * thread before RSI_ServerStart() returns and kept until the next start.
+ * memory_lock and stack_prefault are always RSI_ERROR_NOT_ENABLED.
+ * 
+ * @param server Server to query
+ * @param thread Event-loop thread, from 0 to the number of threads started
+ * @param diagnostics Receives the outcome of each setup step
+ * @return RSI_SUCCESS on success, RSI_ERROR_NOT_RUNNING if the server was never started,
+ *         error code otherwise
+ */
+RSI_Error RSI_ServerGetStartupDiagnostics(RSI_ServerHandle server, uint32_t thread,
+                                          RSI_StartupDiagnostics* diagnostics);
+
+/**
+ * @brief Stop the event-loop threads and close all sockets
+ * 
+ * @param server Server to stop
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_ServerStop(RSI_ServerHandle server);
+
+/**
+ * @brief Stop and free a server
+ * 
+ * Attached instances are detached but not destroyed. Destroy them with
+ * RSI_Destroy() afterwards.
+ * 
+ * @param server Server to destroy; invalid after this call
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_ServerDestroy(RSI_ServerHandle server);
+
+//Latest state of an instance in another process, see RSI_TelemetryRead
+typedef struct {
+    RSI_Frame frame;                     /**< Latest cycle; the percentile fields of its statistics are filled in */
+    RSI_Percentiles response_times;      /**< As RSI_GetPercentiles */
+    RSI_Percentiles jitter;              /**< As RSI_GetJitterPercentiles */
+    bool stage_timing;                   /**< The instance times its stages, stages is valid */
+    RSI_Percentiles stages[RSI_STAGE_COUNT]; /**< As RSI_GetStagePercentiles */
+    uint64_t owner_pid;                  /**< Process that publishes the segment */
+} RSI_TelemetrySnapshot;
+
+/**
+ * @brief Read-only view of an instance's telemetry segment
+ * 
+ * An instance with RSI_Config.telemetry_name set publishes its frame and
+ * latency histograms in a named shared-memory segment, so monitors can run
+ * in a separate process and cannot stall or crash the robot loop. The
+ * network thread pays a frame copy and a few histogram increments per cycle,
+ * however many readers are attached.
+ */
+typedef struct RSI_Telemetry* RSI_TelemetryHandle;
+
+/**
+ * @brief Attach to the telemetry segment of a running instance
+ * 
+ * Needs no RSI_Init(); the segment is mapped read-only.
+ * 
+ * @param name RSI_Config.telemetry_name of the instance
+ * @param handle Receives the reader
+ * @return RSI_SUCCESS on success, RSI_ERROR_NOT_RUNNING if no instance publishes under this name,
+ *         RSI_ERROR_NOT_SUPPORTED if the segment has a different layout version
+ */
+RSI_Error RSI_TelemetryOpen(const char* name, RSI_TelemetryHandle* handle);
+
+/**
+ * @brief Copy the latest published state
+ * 
+ * @param handle Reader
+ * @param snapshot Pointer to structure to receive the state
+ * @return RSI_SUCCESS on success, RSI_ERROR_NOT_RUNNING once the instance has
+ *         been cleaned up, RSI_ERROR_TIMEOUT if its process died while publishing
+ */
+RSI_Error RSI_TelemetryRead(RSI_TelemetryHandle handle, RSI_TelemetrySnapshot* snapshot);
+
+/**
+ * @brief Detach from a telemetry segment
+ * 
+ * @param handle Reader; invalid after this call
+ * @return RSI_SUCCESS on success, error code otherwise
+ */
+RSI_Error RSI_TelemetryClose(RSI_TelemetryHandle handle);
+
 /**
  * @brief Get string representation of error code
  * 
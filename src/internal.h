@@ -9,6 +9,402 @@
 //Include Kuka RSI
 #include "../include/kuka_rsi.h"
 
-/* Private function declarations would go here */
+#include <stddef.h>
+
+#if !defined(_WIN32) && !defined(__linux__)
+    #include <pthread.h>
+#endif
+
+/* Memory ordering for state shared with the network thread */
+#define RSI_LOAD_ACQUIRE(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define RSI_LOAD_RELAXED(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define RSI_STORE_RELEASE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define RSI_STORE_RELAXED(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELAXED)
+#define RSI_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define RSI_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+
+/* Tokenizer limits (per packet) */
+#define RSI_MAX_PACKET_SIZE 4096
+#define RSI_MAX_ELEMENTS 128
+#define RSI_MAX_ATTRIBUTES 512
+
+/**
+ * Non-owning view into the receive buffer
+ */
+typedef struct {
+    const char* ptr;
+    uint32_t len;
+} RSI_Slice;
+
+/**
+ * Attribute of an element, e.g. X="445.0"
+ */
+typedef struct {
+    RSI_Slice name;
+    RSI_Slice value;           /* Without the surrounding quotes */
+} RSI_Attribute;
+
+/**
+ * Element of an RSI packet, e.g. <RIst .../> or <IPOC>123</IPOC>
+ */
+typedef struct {
+    RSI_Slice name;
+    RSI_Slice text;            /* Trimmed character data up to the next tag */
+    uint16_t first_attribute;  /* Index into RSI_Packet.attributes */
+    uint16_t attribute_count;
+} RSI_Element;
+
+/**
+ * Result of tokenizing one datagram.
+ *
+ * All slices point into the tokenized buffer, so the packet is only valid
+ * as long as that buffer is left untouched.
+ */
+typedef struct {
+    uint16_t structural[RSI_MAX_PACKET_SIZE];  /* Offsets of < = " > */
+    RSI_Element elements[RSI_MAX_ELEMENTS];
+    RSI_Attribute attributes[RSI_MAX_ATTRIBUTES];
+    uint16_t element_count;
+    uint16_t attribute_count;
+    bool truncated;            /* More elements/attributes than could be recorded */
+
+    /* Well-known elements, resolved during the pass (NULL if absent) */
+    const RSI_Element* ipoc;
+    const RSI_Element* rist;
+    const RSI_Element* aipos;
+} RSI_Packet;
+
+/**
+ * Structural scanner implementation
+ */
+typedef size_t (*RSI_ScanFunc)(const char* data, size_t len, uint16_t* positions);
+
+typedef struct {
+    const char* name;
+    RSI_ScanFunc scan;
+} RSI_ScanImplementation;
+
+/**
+ * Record the offsets of all '<', '=', '"' and '>' characters
+ *
+ * Uses the fastest implementation the CPU supports. `positions` must have
+ * room for `len` entries.
+ *
+ * @return Number of offsets written
+ */
+size_t rsi_scan_structural(const char* data, size_t len, uint16_t* positions);
+
+/**
+ * Implementations supported on this CPU, fastest first
+ */
+const RSI_ScanImplementation* rsi_scan_available(size_t* count);
+
+/**
+ * Currently selected implementation
+ */
+const RSI_ScanImplementation* rsi_scan_active(void);
+
+/**
+ * Override the selected implementation (benchmarks only)
+ */
+void rsi_scan_use(const RSI_ScanImplementation* implementation);
+
+/**
+ * Tokenize an RSI datagram in a single pass over its structural characters
+ *
+ * @return false if the data is not a well-formed sequence of tags
+ */
+bool rsi_tokenize_packet(const char* data, size_t len, RSI_Packet* packet);
+
+/**
+ * Find the first element with the given name (NULL if absent)
+ */
+const RSI_Element* rsi_find_element(const RSI_Packet* packet, const char* name);
+
+/**
+ * Find an attribute of an element by name (NULL if absent)
+ */
+const RSI_Attribute* rsi_find_attribute(const RSI_Packet* packet,
+                                        const RSI_Element* element,
+                                        const char* name);
+
+/**
+ * Convert a decimal number independently of the process locale
+ *
+ * The whole slice must be consumed. Short fixed-point decimals are
+ * converted exactly without strtod.
+ *
+ * @return false if the slice is not a number
+ */
+bool rsi_parse_double(const char* str, size_t len, double* value);
+
+/**
+ * Convert an unsigned decimal integer that fits in 32 bits
+ */
+bool rsi_parse_uint32(const char* str, size_t len, uint32_t* value);
+
+/**
+ * Format a value with four decimals and a '.' radix, like printf("%.4f")
+ *
+ * @return Length written (excluding the terminator), 0 if it does not fit
+ */
+int rsi_format_fixed4(double value, char* buffer, size_t buffer_size);
+
+/**
+ * Lock-free single-producer/single-consumer ring of fixed-size slots
+ */
+typedef struct {
+    struct {
+        uint64_t head;             /* Next slot to write */
+        uint64_t cached_tail;      /* Consumer position last seen */
+    } producer __attribute__((aligned(64)));
+    struct {
+        uint64_t tail;             /* Next slot to read */
+        uint64_t cached_head;      /* Producer position last seen */
+    } consumer __attribute__((aligned(64)));
+    unsigned char* slots __attribute__((aligned(64)));
+    size_t mask;                   /* Capacity - 1 (capacity is a power of two) */
+    size_t slot_size;
+} RSI_Ring;
+
+/**
+ * Zeroed allocation aligned to a cache line (also used for RSI_Handle)
+ */
+void* rsi_aligned_zalloc(size_t size);
+void rsi_aligned_free(void* ptr);
+
+/**
+ * Allocate a ring; the capacity is rounded up to a power of two
+ */
+bool rsi_ring_init(RSI_Ring* ring, size_t capacity, size_t slot_size);
+void rsi_ring_free(RSI_Ring* ring);
+
+/**
+ * Producer: slot to fill (NULL if full), then publish it
+ */
+void* rsi_ring_begin_write(RSI_Ring* ring);
+void rsi_ring_end_write(RSI_Ring* ring);
+
+/**
+ * Consumer: oldest slot (NULL if empty), then release it
+ */
+const void* rsi_ring_begin_read(RSI_Ring* ring);
+void rsi_ring_end_read(RSI_Ring* ring);
+
+/**
+ * Consumer: copy out and release up to max_count slots
+ */
+size_t rsi_ring_read(RSI_Ring* ring, void* out, size_t max_count);
+
+/**
+ * Producer: position of the next slot to be written
+ */
+uint64_t rsi_ring_write_position(const RSI_Ring* ring);
+
+/**
+ * Consumer: release every slot written before the given producer position
+ */
+void rsi_ring_discard(RSI_Ring* ring, uint64_t until);
+
+/**
+ * Number of filled slots (either side)
+ */
+size_t rsi_ring_count(const RSI_Ring* ring);
+
+/**
+ * Per-cycle wakeup for application threads (see rsi_signal.c)
+ */
+typedef struct {
+    uint32_t sequence;         /* Bumped by every notify */
+    uint32_t waiters;          /* Threads inside rsi_signal_wait */
+#if !defined(_WIN32) && !defined(__linux__)
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+} RSI_Signal;
+
+void rsi_signal_init(RSI_Signal* signal);
+void rsi_signal_destroy(RSI_Signal* signal);
+
+/**
+ * Current sequence; read it before checking the condition to wait for
+ */
+uint32_t rsi_signal_sequence(const RSI_Signal* signal);
+
+/**
+ * Advance the sequence and wake all waiters
+ */
+void rsi_signal_notify(RSI_Signal* signal);
+
+/**
+ * Block until the sequence differs from seen or the timeout expires
+ *
+ * @return true if the sequence changed
+ */
+bool rsi_signal_wait(RSI_Signal* signal, uint32_t seen, uint64_t timeout_us);
+
+/**
+ * Log-linear latency histogram (see rsi_histogram.c)
+ *
+ * Values are grouped by their highest set bit, and each power of two is
+ * split into 2^RSI_HISTOGRAM_SUB_BITS linear buckets, so every bucket is
+ * within 1/64 of the values it holds. Values of 2^RSI_HISTOGRAM_MAX_BITS
+ * and above land in the last bucket.
+ */
+#define RSI_HISTOGRAM_SUB_BITS 6
+#define RSI_HISTOGRAM_MAX_BITS 40
+#define RSI_HISTOGRAM_BUCKETS ((RSI_HISTOGRAM_MAX_BITS - RSI_HISTOGRAM_SUB_BITS + 1) << RSI_HISTOGRAM_SUB_BITS)
+
+typedef struct {
+    uint64_t counts[RSI_HISTOGRAM_BUCKETS];
+} RSI_Histogram;
+
+/**
+ * Writer: count one value (single writer, one relaxed increment)
+ */
+void rsi_histogram_record(RSI_Histogram* histogram, uint64_t value);
+
+/**
+ * Reader: copy the counts without stopping the writer
+ */
+void rsi_histogram_snapshot(const RSI_Histogram* histogram, RSI_Histogram* out);
+
+/**
+ * Percentiles of a snapshot, or of the values recorded between an earlier
+ * snapshot and this one; values are multiplied by scale
+ */
+void rsi_histogram_percentiles(const RSI_Histogram* histogram, const RSI_Histogram* earlier,
+                               double scale, RSI_Percentiles* out);
+
+/**
+ * Tick counter for durations (see rsi_clock.c); selects and calibrates the
+ * source on first use, which can take 10 ms, so call it off the hot path
+ */
+void rsi_clock_init(void);
+uint64_t rsi_clock_ticks(void);
+
+/**
+ * Nanoseconds per tick, and the name of the tick source
+ */
+double rsi_clock_tick_ns(void);
+const char* rsi_clock_name(void);
+
+/**
+ * Overwriting event trace ring with a single writer (see rsi_trace.c)
+ */
+typedef struct {
+    uint64_t sequence;         /* Position + 1 once written, 0 while being written */
+    uint64_t ticks;            /* rsi_clock_ticks() of the event */
+    uint32_t event;            /* RSI_TraceEvent */
+    uint32_t ipoc;
+    uint64_t args[2];
+} RSI_TraceSlot;
+
+typedef struct {
+    uint64_t head __attribute__((aligned(64)));  /* Records written so far */
+    RSI_TraceSlot* slots __attribute__((aligned(64)));
+    uint64_t mask;             /* Capacity - 1 (capacity is a power of two) */
+    double tick_ns;            /* Conversion of slot ticks to timestamps */
+    uint64_t base_ticks;
+    uint64_t base_ns;          /* Monotonic time at base_ticks */
+} RSI_Trace;
+
+/**
+ * Allocate a trace; the capacity is rounded up to a power of two and now_ns
+ * anchors the record timestamps
+ */
+bool rsi_trace_init(RSI_Trace* trace, size_t capacity, uint64_t now_ns);
+void rsi_trace_free(RSI_Trace* trace);
+
+/**
+ * Writer: record one event, overwriting the oldest record when full
+ */
+void rsi_trace_write(RSI_Trace* trace, uint64_t ticks, uint32_t event, uint32_t ipoc,
+                     uint64_t arg0, uint64_t arg1);
+
+/**
+ * Position of the next record to be written (any thread)
+ */
+uint64_t rsi_trace_position(const RSI_Trace* trace);
+
+/**
+ * Reader: copy up to max_count records from *position on and advance it.
+ * Records overwritten before they could be copied are added to *lost.
+ * Any number of readers, each with its own position.
+ */
+size_t rsi_trace_read(const RSI_Trace* trace, uint64_t* position, RSI_TraceRecord* out,
+                      size_t max_count, uint64_t* lost);
+
+/**
+ * Shared-memory telemetry segment (see rsi_telemetry.c). Bump the version
+ * whenever the layout, or that of RSI_Frame, changes.
+ */
+#define RSI_TELEMETRY_MAGIC 0x54495352u   /* "RSIT" */
+#define RSI_TELEMETRY_VERSION 2
+#define RSI_TELEMETRY_NAME_MAX 256
+
+typedef struct {
+    uint32_t magic;            /* RSI_TELEMETRY_MAGIC while the owner publishes, 0 after */
+    uint32_t version;          /* RSI_TELEMETRY_VERSION */
+    uint64_t size;             /* sizeof(RSI_TelemetrySegment) */
+    uint64_t owner_pid;
+    double tick_ns;            /* Scale of the stage histograms */
+    bool stage_timing;         /* stage_histograms are recorded */
+
+    uint32_t sequence __attribute__((aligned(64)));  /* Frame seqlock, odd while writing */
+    RSI_Frame frame;
+    uint64_t response_time_sum_ns; /* For avg_response_time_ms, which readers compute */
+
+    /* Recorded alongside the instance's own histograms */
+    RSI_Histogram response_histogram __attribute__((aligned(64)));
+    RSI_Histogram jitter_histogram;
+    RSI_Histogram stage_histograms[RSI_STAGE_COUNT];
+} RSI_TelemetrySegment;
+
+/* Mapping of a segment, by its owner or by a reader (RSI_TelemetryHandle) */
+struct RSI_Telemetry {
+    RSI_TelemetrySegment* segment;
+    bool writer;
+    void* mapping;             /* File mapping handle (Windows only) */
+    char name[RSI_TELEMETRY_NAME_MAX];
+};
+
+/**
+ * Create and map a segment for publishing; fails if a live process owns
+ * the name. os_error receives errno (GetLastError() on Windows) on failure.
+ */
+struct RSI_Telemetry* rsi_telemetry_create(const char* name, bool stage_timing, double tick_ns,
+                                           int* os_error);
+
+/**
+ * Unmap a segment; the owner also marks it closed and removes the name
+ */
+void rsi_telemetry_destroy(struct RSI_Telemetry* telemetry);
+
+/**
+ * Owner: publish a frame with the sum of its response times
+ */
+void rsi_telemetry_publish(struct RSI_Telemetry* telemetry, const RSI_Frame* frame,
+                           uint64_t response_time_sum_ns);
+
+/*
+ * Hot path of an initialized instance whose network thread is not running,
+ * for rsi_microbench. Both return -1 if the instance cannot be used.
+ */
+
+/**
+ * Process one datagram as the network thread would, but leave the response
+ * in the instance instead of sending it
+ *
+ * @return Length of the response, 0 if the packet was not answered
+ */
+int rsi_process_datagram(RSI_Handle handle, const char* data, size_t len);
+
+/**
+ * Render the response for the given IPOC digits into buffer
+ *
+ * @return Length of the response, 0 if it did not fit
+ */
+int rsi_generate_response(RSI_Handle handle, const char* ipoc, size_t ipoc_len, char* buffer, size_t buffer_size);
 
 #endif /* KUKA_RSI_INTERNAL_H */
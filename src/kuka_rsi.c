@@ -3,6 +3,10 @@
  * @brief Implementation of the KUKA RSI communication library
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE  // ppoll, recvmmsg, pthread_setaffinity_np
+#endif
+
 #include "../include/kuka_rsi.h"
 #include "internal.h"
 
@@ -17,6 +21,7 @@
     #include <windows.h>
     #include <mmsystem.h>  // For timeBeginPeriod
     #include <process.h>   // For _beginthreadex
+    #include <malloc.h>    // For _alloca
     
     typedef SOCKET socket_t;
     #define SOCKET_ERROR_CODE SOCKET_ERROR
@@ -34,6 +39,19 @@
     #include <fcntl.h>
     #include <pthread.h>
     
+    #include <poll.h>
+    #include <sched.h>
+    #include <sys/uio.h>
+    
+    #ifdef __linux__
+        #include <alloca.h>
+        #include <sys/epoll.h>
+        #include <sys/eventfd.h>
+        #include <sys/syscall.h>
+        #include <linux/errqueue.h>
+        #include <linux/net_tstamp.h>
+    #endif
+    
     typedef int socket_t;
     #define SOCKET_ERROR_CODE -1
     #define INVALID_SOCKET_VALUE -1
@@ -46,27 +64,51 @@
 #define DEFAULT_LOCAL_IP "0.0.0.0"
 #define DEFAULT_PORT 59152
 #define DEFAULT_TIMEOUT_MS 1000
-#define MAX_BUFFER_SIZE 4096
+#define MAX_BUFFER_SIZE RSI_MAX_PACKET_SIZE
 #define RESPONSE_BUFFER_SIZE 512
+#define DEFAULT_UNDERRUN_DECAY 0.9
+#define DEFAULT_HYBRID_SPIN_US 500
+#define WAKE_TICK_US 10000        /* Longest sleep of the network thread, bounds RSI_Stop latency */
+#define MAX_CYCLE_US 100000       /* Inter-arrival gaps above this are not robot cycles */
+#define RECV_BATCH 8              /* Datagrams drained per receive call */
+#define CONTROL_SIZE 128          /* Ancillary data per datagram (timestamps) */
+#define DEFAULT_CYCLE_MS 4.0      /* Late threshold until the robot cycle is measured */
+#define IPOC_WINDOW 64            /* Packets per IPOC increment estimate */
+#define REORDER_CYCLES 64         /* Older IPOCs than this start a new sequence instead of counting as reordered */
+#define MAX_DRAIN 64              /* Datagrams of one drain whose IPOCs are checked for continuity */
+#define GAP_EVENT_CAPACITY 64     /* Gaps waiting for the gap callback */
+#define DEFAULT_TRACE_RECORDS 4096
+#define TRACE_PRINT_BATCH 64      /* Trace records the gap thread copies at a time */
+#define DEFAULT_DEADLINE_RUNTIME_US 1000
+#define DEFAULT_DEADLINE_PERIOD_US 4000
+#define MAX_PREFAULT_STACK_KB 512
+#define STACK_TOUCH_STRIDE 4096   /* Stack prefault granularity, at most one page */
+#define LOCKED_STACK_SIZE (512 * 1024) /* Thread stacks while the process is memory-locked */
+#define SERVER_MAX_THREADS 64
+#define SERVER_EVENT_BATCH 32     /* Ready sockets handled per epoll_wait */
 
-/* XML Tag Constants */
-#define TAG_IPOC_START "<IPOC>"
-#define TAG_IPOC_END "</IPOC>"
-#define TAG_RIST_START "<RIst"
-#define TAG_AIPOS_START "<AIPos"
-
-/* Response template */
-static const char *RESPONSE_TEMPLATE = 
+/* Response layout: RKorr X..C attributes and the IPOC digits go in between */
+static const char RESPONSE_HEADER[] =
     "<Sen Type=\"ImFree\">\n"
     "<EStr>RSI Monitor</EStr>\n"
-    "<RKorr X=\"%.4f\" Y=\"%.4f\" Z=\"%.4f\" A=\"%.4f\" B=\"%.4f\" C=\"%.4f\" />\n"
-    "<IPOC>%s</IPOC>\n"
-    "</Sen>";
+    "<RKorr";
+static const char RESPONSE_IPOC_OPEN[] = " />\n<IPOC>";
+static const char RESPONSE_FOOTER[] = "</IPOC>\n</Sen>";
+static const char RESPONSE_AXES[] = "XYZABC";
 
-/* Global state */
+/* Response prefix rendered on an application thread */
 typedef struct {
+    char data[RESPONSE_BUFFER_SIZE];
+    size_t len;
+    RSI_CartesianCorrection correction;
+} __attribute__((aligned(64))) RSI_RenderedResponse;
+
+/* State of one RSI instance */
+struct RSI_Context {
     bool initialized;
     bool running;
+    bool allocated;                    /* Created by RSI_Create, freed by RSI_Destroy */
+    struct RSI_Server* server;         /* Event loop driving this instance, NULL for its own thread */
     
     /* Configuration */
     RSI_Config config;
@@ -74,800 +116,3578 @@ typedef struct {
     /* Socket */
     socket_t sock;
     struct sockaddr_in robot_addr;
+    #ifdef __linux__
+    int epoll_fd;                      /* RSI_WAIT_EPOLL only, -1 otherwise */
+    #endif
     
-    /* Buffers */
-    char recv_buffer[MAX_BUFFER_SIZE] __attribute__((aligned(64)));
+    /* Packet arrival, owned by the network thread */
+    uint64_t last_arrival_ns;          /* Kernel receive time if known, on the monotonic clock */
+    uint64_t cycle_estimate_ns;        /* Smoothed time per robot cycle, 0 until known */
+    uint32_t last_ipoc;
+    uint32_t ipoc_window_min;          /* Smallest IPOC step in the current window */
+    uint32_t ipoc_window_count;
+    double late_threshold_ms;          /* One robot cycle */
+    
+    /* IPOC continuity, owned by the network thread */
+    bool ipoc_tracking;                /* newest_ipoc is from the current connection */
+    uint32_t newest_ipoc;
+    uint64_t newest_arrival_ns;
+    uint32_t recv_stale;               /* Datagrams the last drain skipped as stale */
+    uint32_t drain_ipocs[MAX_DRAIN];   /* IPOCs of the last drain in arrival order */
+    uint32_t drain_count;
+    int32_t drain_answered;            /* Index of the answered datagram in drain_ipocs, -1 if none */
+    
+    /* Buffers; the last slot keeps the datagram to answer while another batch is drained */
+    char recv_buffers[RECV_BATCH + 1][MAX_BUFFER_SIZE] __attribute__((aligned(64)));
+    struct sockaddr_in recv_addrs[RECV_BATCH + 1];
+    uint64_t recv_spare_kernel_us;     /* Kernel receive time of the datagram in the last slot */
+    #ifndef _WIN32
+    char recv_control[RECV_BATCH][CONTROL_SIZE] __attribute__((aligned(8)));
+    struct iovec recv_iov[RECV_BATCH];
+    #endif
+    #ifdef __linux__
+    struct mmsghdr recv_msgs[RECV_BATCH];
+    #endif
+    char* recv_data;                   /* Newest datagram of the last drain */
+    uint64_t recv_kernel_us;           /* Kernel receive time of recv_data (realtime), 0 if unknown */
+    
+    /* Kernel timestamps, owned by the network thread */
+    bool rx_timestamps;                /* Socket delivers kernel receive timestamps */
+    bool tx_timestamps;                /* Socket reports send completion on the error queue */
+    uint32_t tx_key;                   /* SOF_TIMESTAMPING_OPT_ID of the next send */
+    uint64_t e2e_count;                /* Cycles with a kernel receive timestamp */
     char send_buffer[RESPONSE_BUFFER_SIZE] __attribute__((aligned(64)));
     
+    /* Tokens of the packet in recv_data */
+    RSI_Packet packet;
+    
     /* Thread */
     #ifdef _WIN32
     HANDLE network_thread;
-    CRITICAL_SECTION data_lock;
+    HANDLE gap_thread;
+    CRITICAL_SECTION correction_lock;
+    CRITICAL_SECTION window_lock;
     #else
     pthread_t network_thread;
-    pthread_mutex_t data_lock;
+    pthread_t gap_thread;
+    pthread_mutex_t correction_lock;
+    pthread_mutex_t window_lock;
     #endif
     
     /* Callbacks */
     RSI_DataCallback data_callback;
     RSI_ConnectionCallback connection_callback;
     void* callback_user_data;
+    RSI_GapCallback gap_callback;
+    void* gap_user_data;
     
-    /* Robot state */
+    /* Robot state, owned by the network thread */
     RSI_CartesianPosition cartesian;
     RSI_JointPosition joints;
-    RSI_CartesianCorrection correction;
     
-    /* Statistics */
+    /* Last complete cycle as seen by readers (seqlock, odd while writing) */
+    uint32_t frame_sequence __attribute__((aligned(64)));
+    RSI_Frame frame;
+    uint64_t frame_response_sum_ns;    /* response_time_sum_ns of the frame; readers compute the average */
+    
+    /* Wakes RSI_WaitForCycle and RSI_GetEventFd waiters after each cycle */
+    RSI_Signal cycle_signal;
+    int event_fd;                      /* -1 until RSI_GetEventFd creates it */
+    
+    /* IPOC gaps (network thread produces, the gap thread passes them to
+       gap_callback) */
+    RSI_Ring gap_events;
+    RSI_Signal gap_signal;
+    bool gap_thread_running;
+    bool gap_exit;
+    
+    /* Event trace (network thread writes, RSI_DumpTrace and the gap thread
+       read); trace_printed is the gap thread's position with verbose on */
+    RSI_Trace trace;
+    uint64_t trace_printed;
+    
+    /* Shared-memory copy of the frame and histograms for other processes
+       (NULL unless RSI_Config.telemetry_name) */
+    struct RSI_Telemetry* telemetry;
+    
+    /* Response rendered up to the IPOC digits, double-buffered.
+       The network thread uses responses[response_generation & 1]. */
+    RSI_RenderedResponse responses[2];
+    uint32_t response_generation;
+    
+    /* Statistics, owned by the network thread */
     RSI_Statistics stats;
-    
-} RSI_Context;
+    uint64_t response_time_sum_ns;     /* Sum of all response times, for the average */
+    
+    /* Response times and arrival jitter in ns (network thread records,
+       readers snapshot) */
+    RSI_Histogram response_histogram;
+    RSI_Histogram jitter_histogram;
+    
+    /* Stage durations in clock ticks, RSI_STAGE_COUNT histograms
+       (NULL unless RSI_Config.stage_timing) */
+    RSI_Histogram* stage_histograms;
+    uint64_t stage_mark;               /* Tick count at the end of the previous stage */
+    double tick_ns;                    /* Nanoseconds per clock tick */
+    
+    /* Start of the RSI_GetWindowPercentiles window, guarded by window_lock
+       (application threads only) */
+    RSI_Histogram window_start;
+    
+    /* Per-cycle samples (network thread produces, RSI_ReadSamples consumes) */
+    RSI_Ring samples;
+    
+    /* Correction FIFO of rendered responses (RSI_QueueCorrections produces,
+       network thread consumes one per packet) */
+    RSI_Ring correction_queue;
+    uint64_t queue_flush_until;        /* Entries before this position are discarded */
+    
+    /* Underrun state, owned by the network thread */
+    RSI_RenderedResponse held_response;
+    RSI_RenderedResponse zero_response;
+    uint32_t held_generation;          /* response_generation the held response reflects */
+    bool queue_streaming;              /* Last packet was answered from the queue */
+    RSI_RenderedResponse decay_response; /* Next RSI_UNDERRUN_DECAY step of the held response */
+    bool decay_ready;                  /* decay_response was rendered from the current held response */
+    
+    /* Real-time setup, written by RSI_Init and the network thread before RSI_Start returns */
+    RSI_StartupDiagnostics diagnostics;
+    bool thread_ready;                 /* Network thread finished its setup */
+    
+    /* Thread running flag */
+    volatile bool exit_requested;
+};
+
+typedef struct RSI_Context RSI_Context;
 
-/* Global context instance */
+/* Default instance behind the handle-less API */
 static RSI_Context g_context = {0};
 
-/* Thread running flag */
-static volatile bool g_exit_requested = false;
+/* mlockall(MCL_FUTURE) succeeded; it applies to the whole process */
+static bool g_memory_locked = false;
+
+/* One event-loop thread of a server and the instances it serves */
+typedef struct {
+    struct RSI_Server* server;
+    uint32_t index;
+    RSI_Context** members;
+    size_t member_count;
+    #ifdef _WIN32
+    HANDLE thread;
+    WSAPOLLFD* fds;
+    #else
+    pthread_t thread;
+    #ifdef __linux__
+    int epoll_fd;
+    #else
+    struct pollfd* fds;
+    #endif
+    #endif
+    bool ready;                        /* Thread finished its setup */
+} RSI_Shard;
+
+/* Instances sharing a small number of event-loop threads */
+struct RSI_Server {
+    RSI_ServerConfig config;
+    int cpus[SERVER_MAX_THREADS];      /* -1 for unpinned threads */
+    RSI_Context** instances;
+    size_t instance_count;
+    size_t instance_capacity;
+    RSI_Shard* shards;
+    uint32_t shard_count;
+    RSI_StartupDiagnostics diagnostics[SERVER_MAX_THREADS]; /* Per thread, from the last start */
+    uint32_t started_threads;          /* Threads of the last start, 0 before the first */
+    RSI_Signal ready_signal;           /* Notified when a thread finishes its setup */
+    bool running;
+    volatile bool exit_requested;
+};
+
+typedef struct RSI_Server RSI_Server;
 
 /**
- * Get high-precision timestamp in microseconds
+ * Get high-precision timestamp in nanoseconds
  */
-static uint64_t get_time_us(void) {
+static uint64_t get_time_ns(void) {
     #ifdef _WIN32
     LARGE_INTEGER count, freq;
     QueryPerformanceCounter(&count);
     QueryPerformanceFrequency(&freq);
-    return (uint64_t)(count.QuadPart * 1000000ULL / freq.QuadPart);
+    // Split so the multiplication cannot overflow
+    uint64_t seconds = (uint64_t)(count.QuadPart / freq.QuadPart);
+    uint64_t remainder = (uint64_t)(count.QuadPart % freq.QuadPart);
+    return seconds * 1000000000ULL + remainder * 1000000000ULL / (uint64_t)freq.QuadPart;
     #else
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    #endif
+}
+
+/**
+ * Get high-precision timestamp in microseconds
+ */
+static uint64_t get_time_us(void) {
+    return get_time_ns() / 1000;
+}
+
+/**
+ * Record an event in the trace ring
+ */
+static void trace_event(RSI_Context* ctx, RSI_TraceEvent event, uint32_t ipoc,
+                        uint64_t arg0, uint64_t arg1) {
+    rsi_trace_write(&ctx->trace, rsi_clock_ticks(), event, ipoc, arg0, arg1);
+}
+
+/**
+ * Wall-clock time in microseconds, the clock of kernel socket timestamps
+ */
+static uint64_t get_realtime_us(void) {
+    #ifdef _WIN32
+    return 0;
+    #else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
     return (uint64_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000ULL);
     #endif
 }
 
 /**
- * Extract IPOC value from XML data
+ * Parse IPOC value from the <IPOC> element text (0 if not a number)
  */
-static bool extract_ipoc(const char* xml_data, char* ipoc_buffer, size_t buffer_size, uint32_t* ipoc_value) {
-    const char* start_pos = strstr(xml_data, TAG_IPOC_START);
-    if (!start_pos) return false;
-    
-    start_pos += strlen(TAG_IPOC_START);
-    const char* end_pos = strstr(start_pos, TAG_IPOC_END);
-    if (!end_pos) return false;
-    
-    size_t len = end_pos - start_pos;
-    if (len >= buffer_size) len = buffer_size - 1;
-    
-    memcpy(ipoc_buffer, start_pos, len);
-    ipoc_buffer[len] = '\0';
-    
-    if (ipoc_value) {
-        *ipoc_value = (uint32_t)strtoul(ipoc_buffer, NULL, 10);
+static uint32_t parse_ipoc(const RSI_Element* ipoc) {
+    uint32_t value = 0;
+    rsi_parse_uint32(ipoc->text.ptr, ipoc->text.len, &value);
+    return value;
+}
+
+/**
+ * Parse a numeric attribute value (0.0 if not a number)
+ */
+static double parse_attribute_value(const RSI_Attribute* attr) {
+    double value = 0.0;
+    rsi_parse_double(attr->value.ptr, attr->value.len, &value);
+    return value;
+}
+
+/**
+ * Parse Cartesian position from the <RIst> element
+ */
+static bool parse_cartesian_position(const RSI_Packet* packet, RSI_CartesianPosition* position,
+                                     uint64_t timestamp_us) {
+    const RSI_Element* rist = packet->rist;
+    if (!rist) return false;
+    
+    const RSI_Attribute* attr = &packet->attributes[rist->first_attribute];
+    for (uint16_t i = 0; i < rist->attribute_count; i++, attr++) {
+        if (attr->name.len != 1) continue;
+        
+        switch (attr->name.ptr[0]) {
+            case 'X': position->x = parse_attribute_value(attr); break;
+            case 'Y': position->y = parse_attribute_value(attr); break;
+            case 'Z': position->z = parse_attribute_value(attr); break;
+            case 'A': position->a = parse_attribute_value(attr); break;
+            case 'B': position->b = parse_attribute_value(attr); break;
+            case 'C': position->c = parse_attribute_value(attr); break;
+            default: break;
+        }
     }
+    position->timestamp_us = timestamp_us;
     
     return true;
 }
 
 /**
- * Parse position value from attribute
+ * Parse Joint position from the <AIPos> element
  */
-static double parse_position_attr(const char* xml, const char* attr_name) {
-    char search_str[32];
-    snprintf(search_str, sizeof(search_str), "%s=\"", attr_name);
+static bool parse_joint_position(const RSI_Packet* packet, RSI_JointPosition* position, uint64_t timestamp_us) {
+    const RSI_Element* aipos = packet->aipos;
+    if (!aipos) return false;
     
-    const char* attr_pos = strstr(xml, search_str);
-    if (!attr_pos) return 0.0;
+    const RSI_Attribute* attr = &packet->attributes[aipos->first_attribute];
+    for (uint16_t i = 0; i < aipos->attribute_count; i++, attr++) {
+        if (attr->name.len != 2 || attr->name.ptr[0] != 'A') continue;
+        
+        unsigned axis = (unsigned)(attr->name.ptr[1] - '1');
+        if (axis < 6) {
+            position->axis[axis] = parse_attribute_value(attr);
+        }
+    }
+    position->timestamp_us = timestamp_us;
     
-    attr_pos += strlen(search_str);
-    return atof(attr_pos);
+    return true;
 }
 
 /**
- * Parse Cartesian position from XML data
+ * Append raw bytes to a response buffer, keeping room for the terminator
  */
-static bool parse_cartesian_position(const char* xml_data, RSI_CartesianPosition* position) {
-    const char* rist_tag = strstr(xml_data, TAG_RIST_START);
-    if (!rist_tag) return false;
-    
-    position->x = parse_position_attr(rist_tag, "X");
-    position->y = parse_position_attr(rist_tag, "Y");
-    position->z = parse_position_attr(rist_tag, "Z");
-    position->a = parse_position_attr(rist_tag, "A");
-    position->b = parse_position_attr(rist_tag, "B");
-    position->c = parse_position_attr(rist_tag, "C");
-    position->timestamp_us = get_time_us();
+static bool append_bytes(char* buffer, size_t buffer_size, size_t* len, const char* data, size_t data_len) {
+    if (*len + data_len >= buffer_size) {
+        return false;
+    }
     
+    memcpy(buffer + *len, data, data_len);
+    *len += data_len;
+    buffer[*len] = '\0';
     return true;
 }
 
 /**
- * Parse Joint position from XML data
+ * Render the response up to and including <IPOC> for the given correction
  */
-static bool parse_joint_position(const char* xml_data, RSI_JointPosition* position) {
-    const char* aipos_tag = strstr(xml_data, TAG_AIPOS_START);
-    if (!aipos_tag) return false;
+static size_t render_response_prefix(const RSI_CartesianCorrection* correction, char* buffer, size_t buffer_size) {
+    const double values[6] = {
+        correction->x, correction->y, correction->z,
+        correction->a, correction->b, correction->c
+    };
+    size_t len = 0;
+    
+    if (!append_bytes(buffer, buffer_size, &len, RESPONSE_HEADER, sizeof(RESPONSE_HEADER) - 1)) {
+        return 0;
+    }
+    
+    for (int i = 0; i < 6; i++) {
+        const char attr_open[4] = { ' ', RESPONSE_AXES[i], '=', '"' };
+        if (!append_bytes(buffer, buffer_size, &len, attr_open, sizeof(attr_open))) {
+            return 0;
+        }
+        
+        int written = rsi_format_fixed4(values[i], buffer + len, buffer_size - len);
+        if (written == 0) {
+            return 0;
+        }
+        len += (size_t)written;
+        
+        if (!append_bytes(buffer, buffer_size, &len, "\"", 1)) {
+            return 0;
+        }
+    }
     
-    position->axis[0] = parse_position_attr(aipos_tag, "A1");
-    position->axis[1] = parse_position_attr(aipos_tag, "A2");
-    position->axis[2] = parse_position_attr(aipos_tag, "A3");
-    position->axis[3] = parse_position_attr(aipos_tag, "A4");
-    position->axis[4] = parse_position_attr(aipos_tag, "A5");
-    position->axis[5] = parse_position_attr(aipos_tag, "A6");
-    position->timestamp_us = get_time_us();
+    if (!append_bytes(buffer, buffer_size, &len, RESPONSE_IPOC_OPEN, sizeof(RESPONSE_IPOC_OPEN) - 1)) {
+        return 0;
+    }
     
-    return true;
+    return len;
 }
 
 /**
- * Generate response XML with correction values
+ * Render a correction into the spare response buffer and publish it
+ *
+ * Called by application threads only, serialized by correction_lock.
  */
-static int generate_response(const char* ipoc, const RSI_CartesianCorrection* correction, char* buffer, size_t buffer_size) {
-    int written = snprintf(buffer, buffer_size, RESPONSE_TEMPLATE,
-                         correction->x, correction->y, correction->z,
-                         correction->a, correction->b, correction->c,
-                         ipoc);
+static bool publish_correction(RSI_Context* ctx, const RSI_CartesianCorrection* correction) {
+    uint32_t generation = ctx->response_generation + 1;
+    RSI_RenderedResponse* response = &ctx->responses[generation & 1];
     
-    if (written < 0 || written >= (int)buffer_size) {
-        return 0;
+    response->len = render_response_prefix(correction, response->data, sizeof(response->data));
+    if (response->len == 0) {
+        return false;
     }
+    response->correction = *correction;
     
-    return written;
+    RSI_STORE_RELEASE(&ctx->response_generation, generation);
+    return true;
 }
 
 /**
- * Process a packet from the robot
+ * Copy the response published by RSI_SetCartesianCorrection
+ *
+ * @return Length copied, 0 if it does not fit
  */
-static void process_packet(const char* data, int data_len, struct sockaddr_in* robot_addr) {
-    uint64_t start_time = get_time_us();
-    char ipoc_buffer[32] = {0};
-    uint32_t ipoc_value = 0;
-    bool ipoc_extracted;
-    bool cartesian_parsed;
-    bool joints_parsed;
-    int response_len;
-    
-    // Update connection status if needed
-    if (!g_context.stats.is_connected) {
-        g_context.stats.is_connected = true;
-        if (g_context.connection_callback) {
-            g_context.connection_callback(true, g_context.callback_user_data);
+static size_t copy_published_response(RSI_Context* ctx, char* buffer, size_t buffer_size,
+                                      RSI_CartesianCorrection* sent, uint32_t* generation_out) {
+    // Retry if a new correction was published while copying; the writer only
+    // ever renders into the buffer that is not currently published
+    for (;;) {
+        uint32_t generation = RSI_LOAD_ACQUIRE(&ctx->response_generation);
+        const RSI_RenderedResponse* response = &ctx->responses[generation & 1];
+        
+        size_t len = response->len;
+        if (len >= buffer_size) {
+            return 0;
+        }
+        memcpy(buffer, response->data, len);
+        *sent = response->correction;
+        
+        RSI_FENCE_ACQUIRE();
+        if (RSI_LOAD_RELAXED(&ctx->response_generation) == generation) {
+            *generation_out = generation;
+            return len;
         }
     }
-    
-    // Extract IPOC
-    ipoc_extracted = extract_ipoc(data, ipoc_buffer, sizeof(ipoc_buffer), &ipoc_value);
-    if (!ipoc_extracted) {
-        return;
+}
+
+/**
+ * Copy a rendered response and remember it as the held response
+ */
+static size_t use_response(const RSI_RenderedResponse* response, char* buffer, size_t buffer_size,
+                           RSI_CartesianCorrection* sent) {
+    if (response->len >= buffer_size) {
+        return 0;
     }
     
-    // Lock data
-    #ifdef _WIN32
-    EnterCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_lock(&g_context.data_lock);
-    #endif
-    
-    // Parse positions
-    cartesian_parsed = parse_cartesian_position(data, &g_context.cartesian);
-    joints_parsed = parse_joint_position(data, &g_context.joints);
+    memcpy(buffer, response->data, response->len);
+    *sent = response->correction;
+    return response->len;
+}
+
+/**
+ * Render the next RSI_UNDERRUN_DECAY step of the held response
+ *
+ * Runs after the response of a cycle is sent, so the formatting stays off
+ * the receive-to-send path.
+ */
+static void prepare_decay(RSI_Context* ctx) {
+    RSI_RenderedResponse* next = &ctx->decay_response;
+    double decay = ctx->config.underrun_decay;
+    
+    next->correction = ctx->held_response.correction;
+    next->correction.x *= decay;
+    next->correction.y *= decay;
+    next->correction.z *= decay;
+    next->correction.a *= decay;
+    next->correction.b *= decay;
+    next->correction.c *= decay;
+    next->len = render_response_prefix(&next->correction, next->data, sizeof(next->data));
+    ctx->decay_ready = true;
+}
+
+/**
+ * Take the next queued correction, or apply the underrun policy
+ */
+static size_t copy_queued_response(RSI_Context* ctx, char* buffer, size_t buffer_size, RSI_CartesianCorrection* sent) {
+    RSI_RenderedResponse* held = &ctx->held_response;
+    uint32_t generation;
+    
+    // Drop whatever was queued before the last RSI_FlushCorrections
+    rsi_ring_discard(&ctx->correction_queue, RSI_LOAD_ACQUIRE(&ctx->queue_flush_until));
+    
+    const RSI_RenderedResponse* entry = rsi_ring_begin_read(&ctx->correction_queue);
+    if (entry) {
+        memcpy(held->data, entry->data, entry->len);
+        held->len = entry->len;
+        held->correction = entry->correction;
+        ctx->held_generation = RSI_LOAD_RELAXED(&ctx->response_generation);
+        ctx->decay_ready = false;
+        rsi_ring_end_read(&ctx->correction_queue);
+        
+        ctx->queue_streaming = true;
+        ctx->stats.corrections_played++;
+        return use_response(held, buffer, buffer_size, sent);
+    }
     
-    // Update IPOC values
-    if (ipoc_extracted) {
-        g_context.cartesian.ipoc = ipoc_value;
-        g_context.joints.ipoc = ipoc_value;
+    // Queue ran dry
+    if (ctx->queue_streaming) {
+        ctx->queue_streaming = false;
+        ctx->stats.correction_underruns++;
+        trace_event(ctx, RSI_TRACE_UNDERRUN, ctx->cartesian.ipoc, 0, 0);
     }
     
-    // Generate response
-    response_len = generate_response(ipoc_buffer, &g_context.correction, 
-                                   g_context.send_buffer, RESPONSE_BUFFER_SIZE);
+    if (ctx->config.underrun_mode == RSI_UNDERRUN_ZERO) {
+        return use_response(&ctx->zero_response, buffer, buffer_size, sent);
+    }
     
-    // Make a local copy of the robot address
-    struct sockaddr_in addr_copy = *robot_addr;
+    // A correction set after the last queued one replaces the held response
+    if (RSI_LOAD_ACQUIRE(&ctx->response_generation) != ctx->held_generation) {
+        held->len = copy_published_response(ctx, held->data, sizeof(held->data), &held->correction, &generation);
+        if (held->len > 0) {
+            ctx->held_generation = generation;
+        }
+        ctx->decay_ready = false;
+    } else if (ctx->config.underrun_mode == RSI_UNDERRUN_DECAY) {
+        // Normally rendered after the previous send
+        if (!ctx->decay_ready) {
+            prepare_decay(ctx);
+        }
+        memcpy(held->data, ctx->decay_response.data, ctx->decay_response.len);
+        held->len = ctx->decay_response.len;
+        held->correction = ctx->decay_response.correction;
+        ctx->decay_ready = false;
+    }
     
-    #ifdef _WIN32
-    LeaveCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_unlock(&g_context.data_lock);
-    #endif
+    return use_response(held, buffer, buffer_size, sent);
+}
+
+/**
+ * Count the duration of one stage in ticks
+ */
+static void record_stage(RSI_Context* ctx, RSI_Stage stage, uint64_t ticks) {
+    rsi_histogram_record(&ctx->stage_histograms[stage], ticks);
+    if (ctx->telemetry) {
+        rsi_histogram_record(&ctx->telemetry->segment->stage_histograms[stage], ticks);
+    }
+}
+
+/**
+ * End the current stage of the cycle (with RSI_Config.stage_timing)
+ */
+static void mark_stage(RSI_Context* ctx, RSI_Stage stage) {
+    if (ctx->stage_histograms) {
+        uint64_t now = rsi_clock_ticks();
+        record_stage(ctx, stage, now - ctx->stage_mark);
+        ctx->stage_mark = now;
+    }
+}
+
+/**
+ * Complete the response for this cycle with its IPOC digits
+ *
+ * @param sent Receives the correction contained in the response
+ */
+static int generate_response(RSI_Context* ctx, RSI_Slice ipoc, char* buffer, size_t buffer_size,
+                             RSI_CartesianCorrection* sent) {
+    uint32_t generation;
+    size_t len;
     
-    // Call data callback if registered
-    if (g_context.data_callback && cartesian_parsed && joints_parsed) {
-        g_context.data_callback(&g_context.cartesian, &g_context.joints, 
-                              g_context.callback_user_data);
+    if (ctx->correction_queue.slots) {
+        len = copy_queued_response(ctx, buffer, buffer_size, sent);
+    } else {
+        len = copy_published_response(ctx, buffer, buffer_size, sent, &generation);
     }
+    mark_stage(ctx, RSI_STAGE_CORRECTION);
     
-    // Send response
-    if (response_len > 0) {
-        sendto(g_context.sock, g_context.send_buffer, response_len, 0,
-              (struct sockaddr*)&addr_copy, sizeof(addr_copy));
-        g_context.stats.packets_sent++;
+    if (len == 0 ||
+        !append_bytes(buffer, buffer_size, &len, ipoc.ptr, ipoc.len) ||
+        !append_bytes(buffer, buffer_size, &len, RESPONSE_FOOTER, sizeof(RESPONSE_FOOTER) - 1)) {
+        len = 0;
     }
+    mark_stage(ctx, RSI_STAGE_FORMAT);
     
-    // Calculate processing time
-    uint64_t end_time = get_time_us();
-    uint64_t processing_time = end_time - start_time;
-    double processing_time_ms = (double)processing_time / 1000.0;
+    return (int)len;
+}
+
+/**
+ * Publish the network thread's state as one consistent frame
+ *
+ * Readers retry instead of blocking, so the network thread never waits.
+ */
+static void publish_frame(RSI_Context* ctx) {
+    uint32_t sequence = ctx->frame_sequence;
     
-    // Update statistics
-    g_context.stats.packets_received++;
-    g_context.stats.last_packet_timestamp_us = end_time;
-    g_context.stats.avg_response_time_ms = 
-        ((g_context.stats.avg_response_time_ms * (g_context.stats.packets_received - 1)) + 
-         processing_time_ms) / g_context.stats.packets_received;
+    RSI_STORE_RELAXED(&ctx->frame_sequence, sequence + 1);
+    RSI_FENCE_RELEASE();
     
-    if (processing_time_ms < g_context.stats.min_response_time_ms || 
-        g_context.stats.min_response_time_ms == 0.0) {
-        g_context.stats.min_response_time_ms = processing_time_ms;
-    }
+    ctx->frame.cartesian = ctx->cartesian;
+    ctx->frame.joints = ctx->joints;
+    ctx->frame.ipoc = ctx->cartesian.ipoc;
+    ctx->frame.stats = ctx->stats;
+    ctx->frame_response_sum_ns = ctx->response_time_sum_ns;
+    
+    RSI_STORE_RELEASE(&ctx->frame_sequence, sequence + 2);
     
-    if (processing_time_ms > g_context.stats.max_response_time_ms) {
-        g_context.stats.max_response_time_ms = processing_time_ms;
+    if (ctx->telemetry) {
+        rsi_telemetry_publish(ctx->telemetry, &ctx->frame, ctx->response_time_sum_ns);
+    }
+}
+
+/**
+ * Wake application threads waiting for the next cycle
+ */
+static void notify_cycle(RSI_Context* ctx) {
+    rsi_signal_notify(&ctx->cycle_signal);
+    
+    #ifdef __linux__
+    int fd = RSI_LOAD_ACQUIRE(&ctx->event_fd);
+    if (fd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(fd, &one, sizeof(one));
+        (void)written;  // EAGAIN only means the counter is already readable
     }
+    #endif
+}
+
+/**
+ * Copy the last published frame
+ */
+static void read_frame(RSI_Context* ctx, RSI_Frame* frame) {
+    uint64_t response_sum_ns;
     
-    if (processing_time_ms > 4.0) {
-        g_context.stats.late_responses++;
+    for (;;) {
+        uint32_t sequence = RSI_LOAD_ACQUIRE(&ctx->frame_sequence);
+        if (sequence & 1) {
+            continue;
+        }
+        
+        memcpy(frame, &ctx->frame, sizeof(RSI_Frame));
+        response_sum_ns = ctx->frame_response_sum_ns;
         
-        if (g_context.config.verbose) {
-            printf("WARNING: Slow response: %.3f ms\n", processing_time_ms);
+        RSI_FENCE_ACQUIRE();
+        if (RSI_LOAD_RELAXED(&ctx->frame_sequence) == sequence) {
+            break;
         }
     }
+    
+    // The network thread only keeps the sum
+    if (frame->stats.packets_received > 0) {
+        frame->stats.avg_response_time_ms =
+            (double)response_sum_ns / 1000000.0 / (double)frame->stats.packets_received;
+    }
 }
 
 /**
- * Check for connection timeout
+ * Append this cycle to the sample ring (dropped and counted if full)
  */
-static void check_connection_timeout(void) {
-    if (g_context.config.timeout_ms == 0 || !g_context.stats.is_connected) {
+static void record_sample(RSI_Context* ctx, uint64_t receive_time, uint64_t send_time, uint64_t receive_delay,
+                          const RSI_CartesianCorrection* correction) {
+    RSI_Sample* sample = rsi_ring_begin_write(&ctx->samples);
+    if (!sample) {
+        ctx->stats.samples_dropped++;
         return;
     }
     
-    uint64_t current_time = get_time_us();
-    uint64_t time_since_last_packet = current_time - g_context.stats.last_packet_timestamp_us;
-    
-    if (time_since_last_packet > (uint64_t)g_context.config.timeout_ms * 1000) {
-        // Connection timeout
-        g_context.stats.is_connected = false;
-        g_context.stats.connection_lost_count++;
-        
-        if (g_context.connection_callback) {
-            g_context.connection_callback(false, g_context.callback_user_data);
+    sample->ipoc = ctx->cartesian.ipoc;
+    sample->receive_time_us = receive_time;
+    sample->send_time_us = send_time;
+    sample->receive_delay_us = (uint32_t)receive_delay;
+    sample->cartesian[0] = ctx->cartesian.x;
+    sample->cartesian[1] = ctx->cartesian.y;
+    sample->cartesian[2] = ctx->cartesian.z;
+    sample->cartesian[3] = ctx->cartesian.a;
+    sample->cartesian[4] = ctx->cartesian.b;
+    sample->cartesian[5] = ctx->cartesian.c;
+    memcpy(sample->joints, ctx->joints.axis, sizeof(sample->joints));
+    sample->correction = *correction;
+    
+    rsi_ring_end_write(&ctx->samples);
+}
+
+#ifndef _WIN32
+/**
+ * Kernel timestamp in the ancillary data of a received datagram
+ *
+ * @return Realtime microseconds, 0 if the datagram carries none
+ */
+static uint64_t control_timestamp_us(struct msghdr* msg) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
         }
         
-        if (g_context.config.verbose) {
-            printf("RSI: Connection timeout after %u ms\n", g_context.config.timeout_ms);
+        #ifdef __linux__
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            struct scm_timestamping timestamps;
+            memcpy(&timestamps, CMSG_DATA(cmsg), sizeof(timestamps));
+            return (uint64_t)timestamps.ts[0].tv_sec * 1000000ULL + (uint64_t)timestamps.ts[0].tv_nsec / 1000ULL;
+        }
+        if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+        }
+        #else
+        if (cmsg->cmsg_type == SCM_TIMESTAMP) {
+            struct timeval tv;
+            memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+            return (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
         }
+        #endif
     }
+    return 0;
 }
+#endif
 
+#ifdef __linux__
 /**
- * Network thread function
+ * Drain the error queue, looking for the send timestamp with the given key
+ *
+ * @return Realtime microseconds of the send, 0 if not (yet) reported
  */
-#ifdef _WIN32
-static unsigned __stdcall network_thread_func(void* param) {
-#else
-static void* network_thread_func(void* param) {
+static uint64_t read_tx_timestamp(RSI_Context* ctx, uint32_t key) {
+    char control[CONTROL_SIZE] __attribute__((aligned(8)));
+    uint64_t found = 0;
+    
+    for (;;) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        
+        if (recvmsg(ctx->sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return found;
+        }
+        
+        uint64_t timestamp = 0;
+        bool matches = false;
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                timestamp = control_timestamp_us(&msg);
+            } else if (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) {
+                struct sock_extended_err error;
+                memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+                matches = error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING && error.ee_data == key;
+            }
+        }
+        
+        if (matches && timestamp) {
+            found = timestamp;
+        }
+    }
+}
 #endif
-    struct sockaddr_in robot_addr;
-    socklen_t addr_len = sizeof(robot_addr);
-    int recv_len;
+
+/**
+ * Account one cycle measured from the kernel receive timestamp
+ */
+static void update_kernel_latency(RSI_Context* ctx, double receive_delay_ms, double e2e_ms) {
+    RSI_Statistics* stats = &ctx->stats;
+    double count = (double)++ctx->e2e_count;
     
-    // Set thread priority to time-critical
-    #ifdef _WIN32
-    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-    #else
-    struct sched_param schedParam;
-    schedParam.sched_priority = sched_get_priority_max(SCHED_FIFO);
-    pthread_setschedparam(pthread_self(), SCHED_FIFO, &schedParam);
+    stats->kernel_timestamps = true;
     
-    #endif
+    stats->avg_receive_delay_ms += (receive_delay_ms - stats->avg_receive_delay_ms) / count;
+    if (receive_delay_ms > stats->max_receive_delay_ms) {
+        stats->max_receive_delay_ms = receive_delay_ms;
+    }
+    
+    stats->avg_e2e_response_time_ms += (e2e_ms - stats->avg_e2e_response_time_ms) / count;
+    if (ctx->e2e_count == 1 || e2e_ms < stats->min_e2e_response_time_ms) {
+        stats->min_e2e_response_time_ms = e2e_ms;
+    }
+    if (e2e_ms > stats->max_e2e_response_time_ms) {
+        stats->max_e2e_response_time_ms = e2e_ms;
+    }
+    
+    if (e2e_ms > ctx->late_threshold_ms) {
+        stats->late_e2e_responses++;
+        trace_event(ctx, RSI_TRACE_LATE_RESPONSE, ctx->cartesian.ipoc,
+                    (uint64_t)(e2e_ms * 1000000.0), (uint64_t)(receive_delay_ms * 1000000.0));
+    }
+}
+
+/**
+ * Learn the IPOC step of one robot cycle: the smallest step of each window,
+ * so the double steps left by drained packets and lost cycles do not count
+ */
+static void track_ipoc_increment(RSI_Context* ctx, uint32_t ipoc_delta) {
+    RSI_Statistics* stats = &ctx->stats;
     
-    if (g_context.config.verbose) {
-        printf("RSI: Network thread started with high priority\n");
+    if (ctx->ipoc_window_min == 0 || ipoc_delta < ctx->ipoc_window_min) {
+        ctx->ipoc_window_min = ipoc_delta;
     }
     
-    while (!g_exit_requested) {
-        // Receive packet (non-blocking)
-        recv_len = recvfrom(g_context.sock, g_context.recv_buffer, MAX_BUFFER_SIZE - 1, 0,
-                         (struct sockaddr*)&robot_addr, &addr_len);
+    // A smaller step applies at once, a larger one after a full window
+    if (stats->ipoc_increment == 0 || ipoc_delta < stats->ipoc_increment) {
+        stats->ipoc_increment = ipoc_delta;
+    }
+    if (++ctx->ipoc_window_count == IPOC_WINDOW) {
+        stats->ipoc_increment = ctx->ipoc_window_min;
+        ctx->ipoc_window_min = 0;
+        ctx->ipoc_window_count = 0;
+    }
+}
+
+/**
+ * Update the robot cycle and the arrival jitter from the arrival of a packet
+ */
+static void track_arrival(RSI_Context* ctx, uint64_t arrival_ns, uint32_t ipoc) {
+    RSI_Statistics* stats = &ctx->stats;
+    uint64_t interval = arrival_ns - ctx->last_arrival_ns;
+    uint32_t ipoc_delta = ipoc - ctx->last_ipoc;
+    
+    // Skip the first packet, reconnects, duplicates, reordering and IPOC resets
+    if (ctx->last_arrival_ns != 0 && interval < MAX_CYCLE_US * 1000ULL &&
+        ipoc_delta > 0 && ipoc_delta <= MAX_CYCLE_US / 1000) {
+        track_ipoc_increment(ctx, ipoc_delta);
         
-        if (recv_len > 0) {
-            // Null-terminate received data
-            g_context.recv_buffer[recv_len] = '\0';
+        // Robot cycles since the last packet
+        uint32_t increment = stats->ipoc_increment;
+        uint64_t steps = (ipoc_delta + increment / 2) / increment;
+        if (steps == 0) {
+            steps = 1;
+        }
+        
+        // Deviation from the expected arrival time
+        if (ctx->cycle_estimate_ns != 0) {
+            uint64_t expected = steps * ctx->cycle_estimate_ns;
+            uint64_t jitter = interval > expected ? interval - expected : expected - interval;
+            double jitter_ms = (double)jitter / 1000000.0;
             
-            // Process and respond
-            process_packet(g_context.recv_buffer, recv_len, &robot_addr);
+            rsi_histogram_record(&ctx->jitter_histogram, jitter);
+            if (ctx->telemetry) {
+                rsi_histogram_record(&ctx->telemetry->segment->jitter_histogram, jitter);
+            }
+            if (jitter_ms > stats->max_jitter_ms) {
+                stats->max_jitter_ms = jitter_ms;
+            }
         }
         
-        // Check for connection timeout
-        check_connection_timeout();
+        // Exponential average of the time per cycle with weight 1/8
+        int64_t per_cycle = (int64_t)(interval / steps);
+        if (ctx->cycle_estimate_ns == 0) {
+            ctx->cycle_estimate_ns = (uint64_t)per_cycle;
+        } else {
+            ctx->cycle_estimate_ns += (per_cycle - (int64_t)ctx->cycle_estimate_ns) / 8;
+        }
         
-        // Yield thread briefly without sleeping
-        #ifdef _WIN32
-        SwitchToThread();
-        #else
-        sched_yield();
-        #endif
+        stats->robot_cycle_ms = (double)ctx->cycle_estimate_ns / 1000000.0;
+        ctx->late_threshold_ms = stats->robot_cycle_ms;
     }
     
-    if (g_context.config.verbose) {
-        printf("RSI: Network thread exiting\n");
+    ctx->last_arrival_ns = arrival_ns;
+    ctx->last_ipoc = ipoc;
+}
+
+/**
+ * Hand a gap to the gap thread (dropped if it is not keeping up)
+ */
+static void report_gap(RSI_Context* ctx, uint32_t last_ipoc, uint32_t ipoc, uint32_t missing,
+                       uint64_t receive_time) {
+    RSI_IpocGap* gap = rsi_ring_begin_write(&ctx->gap_events);
+    if (!gap) {
+        return;
     }
     
-    return 0;
+    gap->last_ipoc = last_ipoc;
+    gap->ipoc = ipoc;
+    gap->missing_cycles = missing;
+    gap->timestamp_us = receive_time;
+    rsi_ring_end_write(&ctx->gap_events);
+    rsi_signal_notify(&ctx->gap_signal);
 }
 
 /**
- * Create and configure socket for minimal latency
+ * Check the IPOC of a packet against the newest one of this connection
+ *
+ * @param elapsed Time since the newest packet of the previous drain arrived
+ * @param arrived_later Cycles skipped by this packet whose packets came later in the same drain
+ * @param was_missing A packet older than the newest was counted as missing before
  */
-static RSI_Error create_optimized_socket(const char* local_ip, uint16_t local_port) {
-    struct sockaddr_in local_addr;
-    int reuse = 1;
+static void track_continuity(RSI_Context* ctx, uint32_t ipoc, uint64_t arrival_ns, uint64_t elapsed,
+                             uint64_t receive_time, uint32_t arrived_later, bool was_missing) {
+    RSI_Statistics* stats = &ctx->stats;
+    uint32_t increment = stats->ipoc_increment;
+    int32_t delta = (int32_t)(ipoc - ctx->newest_ipoc);
+    
+    if (!ctx->ipoc_tracking || increment == 0) {
+        ctx->ipoc_tracking = true;
+        ctx->newest_ipoc = ipoc;
+        ctx->newest_arrival_ns = arrival_ns;
+        return;
+    }
     
-    // Create UDP socket
-    g_context.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (g_context.sock == INVALID_SOCKET_VALUE) {
-        if (g_context.config.verbose) {
-            printf("RSI: Failed to create socket, error: %d\n", GET_SOCKET_ERROR);
-        }
-        return RSI_ERROR_SOCKET_FAILED;
+    if (delta == 0) {
+        stats->ipoc_duplicates++;
+        trace_event(ctx, RSI_TRACE_IPOC_DUPLICATE, ipoc, 0, 0);
+        return;
     }
     
-    // Allow address reuse
-    if (setsockopt(g_context.sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse)) < 0) {
-        if (g_context.config.verbose) {
-            printf("RSI: setsockopt(SO_REUSEADDR) failed, error: %d\n", GET_SOCKET_ERROR);
+    if (delta < 0 && (uint32_t)-delta <= REORDER_CYCLES * increment) {
+        // A late packet was counted as missing when its successor arrived,
+        // unless both came in the same drain
+        stats->ipoc_out_of_order++;
+        trace_event(ctx, RSI_TRACE_IPOC_OUT_OF_ORDER, ipoc, ctx->newest_ipoc, 0);
+        if (was_missing && stats->ipoc_missing_cycles > 0) {
+            stats->ipoc_missing_cycles--;
         }
+        return;
     }
     
-    // Set large socket buffers
-    int rcvbuf_size = 1048576;  // 1MB
-    int sndbuf_size = 1048576;  // 1MB
+    uint64_t steps = delta > 0 ? ((uint32_t)delta + increment / 2) / increment : 0;
+    uint32_t last_ipoc = ctx->newest_ipoc;
     
-    if (setsockopt(g_context.sock, SOL_SOCKET, SO_RCVBUF, (const char*)&rcvbuf_size, sizeof(rcvbuf_size)) < 0) {
-        if (g_context.config.verbose) {
-            printf("RSI: setsockopt(SO_RCVBUF) failed, error: %d\n", GET_SOCKET_ERROR);
-        }
+    ctx->newest_ipoc = ipoc;
+    ctx->newest_arrival_ns = arrival_ns;
+    
+    // A jump the elapsed time cannot explain is a restarted IPOC sequence
+    uint64_t cycle = ctx->cycle_estimate_ns;
+    if (steps == 0 || (cycle != 0 && steps > 2 * (elapsed / cycle) + 2)) {
+        return;
     }
     
-    if (setsockopt(g_context.sock, SOL_SOCKET, SO_SNDBUF, (const char*)&sndbuf_size, sizeof(sndbuf_size)) < 0) {
-        if (g_context.config.verbose) {
-            printf("RSI: setsockopt(SO_SNDBUF) failed, error: %d\n", GET_SOCKET_ERROR);
-        }
+    // Packets still to come in this drain are late, not missing
+    if (steps <= 1 + (uint64_t)arrived_later) {
+        return;
     }
     
-    // Set up local address
-    memset(&local_addr, 0, sizeof(local_addr));
-    local_addr.sin_family = AF_INET;
-    local_addr.sin_port = htons(local_port);
+    uint64_t missing = steps - 1 - arrived_later;
+    stats->ipoc_missing_cycles += missing;
+    if (missing > stats->ipoc_longest_gap) {
+        stats->ipoc_longest_gap = (uint32_t)missing;
+    }
+    trace_event(ctx, RSI_TRACE_IPOC_GAP, ipoc, last_ipoc, missing);
     
-    if (strcmp(local_ip, "0.0.0.0") == 0) {
-        local_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (ctx->gap_callback) {
+        report_gap(ctx, last_ipoc, ipoc, (uint32_t)missing, receive_time);
+    }
+}
+
+/**
+ * Check the IPOCs of every datagram of the last drain, in arrival order
+ *
+ * Stale datagrams are not answered, but they did arrive, so a duplicate or
+ * a reordered packet among them is counted as such and not as a missing
+ * cycle. Beyond MAX_DRAIN datagrams only the answered one is checked.
+ *
+ * @param ipoc IPOC of the answered datagram
+ */
+static void track_drain(RSI_Context* ctx, uint32_t ipoc, uint64_t arrival_ns, uint64_t receive_time) {
+    uint32_t* ipocs = ctx->drain_ipocs;
+    uint32_t count = ctx->drain_count;
+    bool tracking = ctx->ipoc_tracking;
+    uint32_t floor = ctx->newest_ipoc;
+    uint64_t elapsed = arrival_ns - ctx->newest_arrival_ns;
+    
+    // Without a scanned IPOC, the answered datagram is the only one
+    if (ctx->drain_answered >= 0) {
+        ipocs[ctx->drain_answered] = ipoc;
     } else {
-        local_addr.sin_addr.s_addr = inet_addr(local_ip);
+        ipocs[0] = ipoc;
+        count = 1;
     }
     
-    if (g_context.config.verbose) {
-        printf("RSI: Binding to %s:%d\n", local_ip, local_port);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t newest = ctx->newest_ipoc;
+        uint32_t arrived_later = 0;
+        
+        // Distinct later IPOCs between the newest and this one
+        for (uint32_t j = i + 1; j < count; j++) {
+            bool repeated = false;
+            if ((int32_t)(ipocs[j] - newest) <= 0 || (int32_t)(ipocs[j] - ipocs[i]) >= 0) {
+                continue;
+            }
+            for (uint32_t k = i + 1; k < j && !repeated; k++) {
+                repeated = ipocs[k] == ipocs[j];
+            }
+            arrived_later += repeated ? 0 : 1;
+        }
+        
+        bool was_missing = tracking && (int32_t)(ipocs[i] - floor) <= 0;
+        track_continuity(ctx, ipocs[i], arrival_ns, elapsed, receive_time, arrived_later, was_missing);
     }
+}
+
+/**
+ * Process a packet from the robot
+ *
+ * @param robot_addr Where to send the response, NULL to leave it in ctx->send_buffer
+ * @return Length of the response, 0 if the packet was not answered
+ */
+static int process_packet(RSI_Context* ctx, const char* data, int data_len, struct sockaddr_in* robot_addr) {
+    // One clock read per packet; durations come from the tick counter.
+    // Ticks are read second so end times derived from them never run ahead.
+    uint64_t start_ns = get_time_ns();
+    uint64_t start_ticks = rsi_clock_ticks();
+    uint64_t start_time = start_ns / 1000;
+    uint64_t receive_kernel = ctx->recv_kernel_us;
+    uint64_t start_real = receive_kernel ? get_realtime_us() : 0;
+    uint64_t send_real = 0;
+    uint32_t ipoc_value = 0;
+    bool cartesian_parsed;
+    bool joints_parsed;
+    int response_len;
+    RSI_CartesianCorrection sent_correction;
     
-    // Bind socket to local address
-    if (bind(g_context.sock, (struct sockaddr*)&local_addr, sizeof(local_addr)) == SOCKET_ERROR_CODE) {
-        if (g_context.config.verbose) {
-            printf("RSI: Bind failed, error: %d\n", GET_SOCKET_ERROR);
+    // Update connection status if needed
+    if (!ctx->stats.is_connected) {
+        ctx->stats.is_connected = true;
+        rsi_trace_write(&ctx->trace, start_ticks, RSI_TRACE_CONNECTED, 0, 0, 0);
+        if (ctx->connection_callback) {
+            ctx->connection_callback(true, ctx->callback_user_data);
         }
-        CLOSE_SOCKET(g_context.sock);
-        return RSI_ERROR_SOCKET_FAILED;
     }
     
-    // Set socket to non-blocking mode
-    #ifdef _WIN32
-    u_long mode = 1;
-    if (ioctlsocket(g_context.sock, FIONBIO, &mode) == SOCKET_ERROR) {
-        if (g_context.config.verbose) {
-            printf("RSI: ioctlsocket failed with error: %d\n", GET_SOCKET_ERROR);
+    ctx->stage_mark = start_ticks;
+    
+    // Tokenize the whole datagram in one pass
+    if (!rsi_tokenize_packet(data, (size_t)data_len, &ctx->packet) ||
+        !ctx->packet.ipoc) {
+        trace_event(ctx, RSI_TRACE_BAD_PACKET, 0, (uint64_t)data_len, 0);
+        publish_frame(ctx);
+        return 0;
+    }
+    
+    // Extract IPOC
+    ipoc_value = parse_ipoc(ctx->packet.ipoc);
+    if (ctx->recv_stale > 0) {
+        trace_event(ctx, RSI_TRACE_STALE_PACKETS, ipoc_value, ctx->recv_stale, 0);
+    }
+    
+    // Time the datagram spent in the kernel before this thread picked it up
+    uint64_t receive_delay = 0;
+    if (receive_kernel && start_real > receive_kernel) {
+        receive_delay = start_real - receive_kernel;
+    }
+    
+    uint64_t arrival_ns = start_ns - receive_delay * 1000;
+    track_arrival(ctx, arrival_ns, ipoc_value);
+    track_drain(ctx, ipoc_value, arrival_ns, start_time);
+    mark_stage(ctx, RSI_STAGE_IPOC);
+    
+    // Parse positions
+    cartesian_parsed = parse_cartesian_position(&ctx->packet, &ctx->cartesian, start_time);
+    joints_parsed = parse_joint_position(&ctx->packet, &ctx->joints, start_time);
+    
+    // Update IPOC values
+    ctx->cartesian.ipoc = ipoc_value;
+    ctx->joints.ipoc = ipoc_value;
+    mark_stage(ctx, RSI_STAGE_PARSE);
+    
+    // Splice the IPOC into the pre-rendered response
+    response_len = generate_response(ctx, ctx->packet.ipoc->text,
+                                   ctx->send_buffer, RESPONSE_BUFFER_SIZE,
+                                   &sent_correction);
+    
+    // Call data callback if registered
+    if (ctx->data_callback && cartesian_parsed && joints_parsed) {
+        ctx->data_callback(&ctx->cartesian, &ctx->joints, 
+                              ctx->callback_user_data);
+    }
+    mark_stage(ctx, RSI_STAGE_CALLBACK);
+    
+    // Send response
+    if (response_len > 0 && robot_addr) {
+        sendto(ctx->sock, ctx->send_buffer, response_len, 0,
+              (struct sockaddr*)robot_addr, sizeof(*robot_addr));
+        ctx->stats.packets_sent++;
+        
+        // Loopback and most drivers report the send before sendto returns
+        #ifdef __linux__
+        if (ctx->tx_timestamps) {
+            send_real = read_tx_timestamp(ctx, ctx->tx_key++);
         }
-        CLOSE_SOCKET(g_context.sock);
-        return RSI_ERROR_SOCKET_FAILED;
+        #endif
     }
-    #else
-    int flags = fcntl(g_context.sock, F_GETFL, 0);
-    if (flags < 0 || fcntl(g_context.sock, F_SETFL, flags | O_NONBLOCK) < 0) {
-        if (g_context.config.verbose) {
-            printf("RSI: fcntl failed with error: %d\n", errno);
+    mark_stage(ctx, RSI_STAGE_SEND);
+    
+    // Calculate processing time
+    uint64_t end_ticks = ctx->stage_histograms ? ctx->stage_mark : rsi_clock_ticks();
+    uint64_t end_ns = start_ns + (uint64_t)((double)(end_ticks - start_ticks) * ctx->tick_ns);
+    uint64_t end_time = end_ns / 1000;
+    uint64_t processing_time = end_time - start_time;
+    double processing_time_ms = (double)(end_ns - start_ns) / 1000000.0;
+    
+    // Percentiles come from the histogram; one increment per cycle
+    rsi_histogram_record(&ctx->response_histogram, end_ns - start_ns);
+    if (ctx->telemetry) {
+        rsi_histogram_record(&ctx->telemetry->segment->response_histogram, end_ns - start_ns);
+    }
+    rsi_trace_write(&ctx->trace, start_ticks, RSI_TRACE_CYCLE, ipoc_value,
+                    end_ns - start_ns, receive_delay * 1000);
+    
+    // With an empty queue the next packet decays the held response; render it now
+    if (ctx->config.underrun_mode == RSI_UNDERRUN_DECAY && ctx->correction_queue.slots &&
+        !ctx->decay_ready && rsi_ring_count(&ctx->correction_queue) == 0) {
+        prepare_decay(ctx);
+    }
+    
+    // Record the cycle for RSI_ReadSamples
+    if (ctx->samples.slots && response_len > 0) {
+        record_sample(ctx, start_time, end_time, receive_delay, &sent_correction);
+    }
+    
+    // End-to-end latency from kernel receive to send completion
+    if (receive_kernel && response_len > 0) {
+        if (send_real == 0) {
+            send_real = start_real + processing_time;
         }
-        CLOSE_SOCKET(g_context.sock);
-        return RSI_ERROR_SOCKET_FAILED;
+        update_kernel_latency(ctx, (double)receive_delay / 1000.0,
+                              (double)(int64_t)(send_real - receive_kernel) / 1000.0);
     }
-    #endif
     
-    if (g_context.config.verbose) {
-        printf("RSI: Socket configured for minimal latency\n");
+    // Update statistics
+    ctx->stats.packets_received++;
+    ctx->stats.last_packet_timestamp_us = end_time;
+    if (ctx->correction_queue.slots) {
+        ctx->stats.correction_queue_depth = (uint32_t)rsi_ring_count(&ctx->correction_queue);
     }
+    ctx->response_time_sum_ns += end_ns - start_ns;
     
-    return RSI_SUCCESS;
+    if (processing_time_ms < ctx->stats.min_response_time_ms || 
+        ctx->stats.min_response_time_ms == 0.0) {
+        ctx->stats.min_response_time_ms = processing_time_ms;
+    }
+    
+    if (processing_time_ms > ctx->stats.max_response_time_ms) {
+        ctx->stats.max_response_time_ms = processing_time_ms;
+    }
+    
+    if (processing_time_ms > ctx->late_threshold_ms) {
+        ctx->stats.late_responses++;
+        trace_event(ctx, RSI_TRACE_SLOW_RESPONSE, ipoc_value, end_ns - start_ns,
+                    (uint64_t)(ctx->late_threshold_ms * 1000000.0));
+    }
+    
+    // Make this cycle visible to readers
+    publish_frame(ctx);
+    notify_cycle(ctx);
+    
+    return response_len;
 }
 
 /**
- * Initialize system optimizations
+ * Check for connection timeout
  */
-static void init_system_optimizations(void) {
-    // Set Windows timer resolution to 1ms
-    #ifdef _WIN32
-    timeBeginPeriod(1);
-    #endif
+static void check_connection_timeout(RSI_Context* ctx) {
+    if (ctx->config.timeout_ms == 0 || !ctx->stats.is_connected) {
+        return;
+    }
     
-    // Initialize synchronization primitives
-    #ifdef _WIN32
-    InitializeCriticalSectionAndSpinCount(&g_context.data_lock, 4000);
+    uint64_t current_time = get_time_us();
+    uint64_t last_packet = ctx->stats.last_packet_timestamp_us;
+    
+    // The last packet time is derived from the tick counter and may be a
+    // fraction of a microsecond ahead of this clock read
+    if (current_time > last_packet &&
+        current_time - last_packet > (uint64_t)ctx->config.timeout_ms * 1000) {
+        // Connection timeout
+        ctx->stats.is_connected = false;
+        ctx->stats.connection_lost_count++;
+        ctx->ipoc_tracking = false;
+        publish_frame(ctx);
+        
+        if (ctx->connection_callback) {
+            ctx->connection_callback(false, ctx->callback_user_data);
+        }
+        
+        trace_event(ctx, RSI_TRACE_CONNECTION_TIMEOUT, 0, ctx->config.timeout_ms, 0);
+    }
+}
+
+/**
+ * Read the IPOC of a datagram without tokenizing it
+ *
+ * The IPOC element comes last in robot packets, so it is searched from the end.
+ */
+static bool scan_ipoc(const char* data, int len, uint32_t* ipoc) {
+    static const char TAG[] = "<IPOC>";
+    const int tag_len = (int)sizeof(TAG) - 1;
+    
+    for (int i = len - tag_len; i >= 0; i--) {
+        if (data[i] == '<' && memcmp(data + i, TAG, (size_t)tag_len) == 0) {
+            const char* digits = data + i + tag_len;
+            const char* end = memchr(digits, '<', (size_t)(len - i - tag_len));
+            return end && rsi_parse_uint32(digits, (size_t)(end - digits), ipoc);
+        }
+    }
+    return false;
+}
+
+/**
+ * Note the IPOC of a drained datagram and decide whether it replaces the one to answer
+ *
+ * The newest IPOC wins, compared as serial numbers so the sequence may wrap.
+ * Of equal IPOCs the first one wins. A datagram without a readable IPOC is
+ * only answered (as a bad packet) if nothing better arrived.
+ */
+static bool drain_prefers(RSI_Context* ctx, const char* data, int len, bool* best_valid, uint32_t* best_ipoc) {
+    uint32_t ipoc;
+    
+    if (!scan_ipoc(data, len, &ipoc)) {
+        return !*best_valid;
+    }
+    
+    bool newer = !*best_valid || (int32_t)(ipoc - *best_ipoc) > 0;
+    if (ctx->drain_count < MAX_DRAIN) {
+        ctx->drain_ipocs[ctx->drain_count++] = ipoc;
+    } else if (newer) {
+        ctx->drain_ipocs[MAX_DRAIN - 1] = ipoc;
+    }
+    if (!newer) {
+        return false;
+    }
+    ctx->drain_answered = (int32_t)ctx->drain_count - 1;
+    *best_valid = true;
+    *best_ipoc = ipoc;
+    return true;
+}
+
+/**
+ * Drain every queued datagram and keep only the newest
+ *
+ * After a scheduling hiccup several packets can be waiting. Answering each
+ * of them in turn would keep the thread behind for many cycles, so only the
+ * datagram with the newest IPOC is answered and the others are counted as
+ * stale. Reordered packets arrive after their successor, so the newest IPOC
+ * is not always the last datagram to arrive. Blocks for the first datagram
+ * only if the socket is blocking.
+ *
+ * @return Length of the datagram to answer (in ctx->recv_data), <= 0 if none
+ */
+static int receive_packet(RSI_Context* ctx, struct sockaddr_in* robot_addr) {
+    uint64_t receive_start = ctx->stage_histograms ? rsi_clock_ticks() : 0;
+    int best = -1;
+    int recv_len = -1;
+    uint64_t received = 0;
+    bool best_valid = false;
+    uint32_t best_ipoc = 0;
+    
+    ctx->drain_count = 0;
+    ctx->drain_answered = -1;
+    
+    #ifdef __linux__
+    int count;
+    int flags = MSG_WAITFORONE;
+    do {
+        for (int i = 0; i < RECV_BATCH; i++) {
+            ctx->recv_msgs[i].msg_hdr.msg_namelen = sizeof(ctx->recv_addrs[i]);
+            ctx->recv_msgs[i].msg_hdr.msg_controllen = ctx->rx_timestamps ? CONTROL_SIZE : 0;
+        }
+        
+        count = recvmmsg(ctx->sock, ctx->recv_msgs, RECV_BATCH, flags, NULL);
+        for (int i = 0; i < count; i++) {
+            int len = (int)ctx->recv_msgs[i].msg_len;
+            if (drain_prefers(ctx, ctx->recv_buffers[i], len, &best_valid, &best_ipoc)) {
+                best = i;
+                recv_len = len;
+            }
+        }
+        if (count > 0) {
+            received += (uint64_t)count;
+        } else if (best < 0) {
+            recv_len = count;
+        }
+        flags = MSG_DONTWAIT;
+        
+        // The next batch overwrites this one; move the datagram to answer aside
+        if (count == RECV_BATCH && best >= 0 && best < RECV_BATCH) {
+            memcpy(ctx->recv_buffers[RECV_BATCH], ctx->recv_buffers[best], (size_t)recv_len);
+            ctx->recv_addrs[RECV_BATCH] = ctx->recv_addrs[best];
+            ctx->recv_spare_kernel_us = ctx->rx_timestamps ?
+                control_timestamp_us(&ctx->recv_msgs[best].msg_hdr) : 0;
+            best = RECV_BATCH;
+        }
+    } while (count == RECV_BATCH);
     #else
-    pthread_mutex_init(&g_context.data_lock, NULL);
+    // Alternate between two buffers, never overwriting the datagram to answer
+    #ifndef _WIN32
+    uint64_t kernel_us[2] = { 0, 0 };
+    #endif
+    int slot = 0;
+    for (;;) {
+        int flags = 0;
+        int len;
+        
+        if (received > 0) {
+            #ifdef _WIN32
+            u_long pending = 0;
+            if (ioctlsocket(ctx->sock, FIONREAD, &pending) != 0 || pending == 0) {
+                break;
+            }
+            #else
+            flags = MSG_DONTWAIT;
+            #endif
+        }
+        
+        #ifdef _WIN32
+        socklen_t addr_len = sizeof(ctx->recv_addrs[slot]);
+        len = recvfrom(ctx->sock, ctx->recv_buffers[slot], MAX_BUFFER_SIZE - 1, flags,
+                       (struct sockaddr*)&ctx->recv_addrs[slot], &addr_len);
+        #else
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &ctx->recv_addrs[slot];
+        msg.msg_namelen = sizeof(ctx->recv_addrs[slot]);
+        msg.msg_iov = &ctx->recv_iov[slot];
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctx->recv_control[slot];
+        msg.msg_controllen = ctx->rx_timestamps ? CONTROL_SIZE : 0;
+        len = (int)recvmsg(ctx->sock, &msg, flags);
+        if (len > 0) {
+            kernel_us[slot] = control_timestamp_us(&msg);
+        }
+        #endif
+        if (len <= 0) {
+            if (best < 0) {
+                recv_len = len;
+            }
+            break;
+        }
+        
+        received++;
+        if (drain_prefers(ctx, ctx->recv_buffers[slot], len, &best_valid, &best_ipoc)) {
+            best = slot;
+            recv_len = len;
+            slot ^= 1;
+        }
+    }
     #endif
     
-    // Set process priority to high
-    #ifdef _WIN32
-    SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+    if (best < 0) {
+        // A late send timestamp makes the socket poll as ready; drop it
+        #ifdef __linux__
+        if (ctx->tx_timestamps) {
+            read_tx_timestamp(ctx, UINT32_MAX);
+        }
+        #endif
+        return recv_len;
+    }
+    
+    #ifdef __linux__
+    if (best == RECV_BATCH) {
+        ctx->recv_kernel_us = ctx->recv_spare_kernel_us;
+    } else {
+        ctx->recv_kernel_us = ctx->rx_timestamps ?
+            control_timestamp_us(&ctx->recv_msgs[best].msg_hdr) : 0;
+    }
+    #elif defined(_WIN32)
+    ctx->recv_kernel_us = 0;
     #else
-    /* Linux priority setup would go here */
+    ctx->recv_kernel_us = kernel_us[best];
     #endif
     
-    if (g_context.config.verbose) {
-        printf("RSI: System optimizations applied\n");
+    ctx->stats.stale_packets_dropped += received - 1;
+    ctx->recv_stale = (uint32_t)(received - 1);
+    ctx->recv_data = ctx->recv_buffers[best];
+    *robot_addr = ctx->recv_addrs[best];
+    
+    if (ctx->stage_histograms) {
+        record_stage(ctx, RSI_STAGE_RECEIVE, rsi_clock_ticks() - receive_start);
     }
+    return recv_len;
 }
 
 /**
- * Clean up system optimizations
+ * Sleep until the socket is readable or the timeout expires
  */
-static void cleanup_system_optimizations(void) {
-    // Reset Windows timer resolution
+static bool wait_readable(RSI_Context* ctx, uint64_t timeout_us) {
     #ifdef _WIN32
-    timeEndPeriod(1);
-    #endif
+    WSAPOLLFD pfd = { ctx->sock, POLLRDNORM, 0 };
+    return WSAPoll(&pfd, 1, (INT)(timeout_us / 1000)) > 0;
+    #else
+    #ifdef __linux__
+    if (ctx->epoll_fd >= 0) {
+        struct epoll_event event;
+        return epoll_wait(ctx->epoll_fd, &event, 1, (int)(timeout_us / 1000)) > 0;
+    }
     
-    // Clean up synchronization primitives
+    // Microsecond timeout for the hybrid strategy
+    struct pollfd pfd = { ctx->sock, POLLIN, 0 };
+    struct timespec timeout;
+    timeout.tv_sec = (time_t)(timeout_us / 1000000);
+    timeout.tv_nsec = (long)(timeout_us % 1000000) * 1000;
+    return ppoll(&pfd, 1, &timeout, NULL) > 0;
+    #else
+    struct pollfd pfd = { ctx->sock, POLLIN, 0 };
+    return poll(&pfd, 1, (int)(timeout_us / 1000)) > 0;
+    #endif
+    #endif
+}
+
+/**
+ * Yield the CPU between polls without sleeping
+ */
+static void yield_thread(void) {
     #ifdef _WIN32
-    DeleteCriticalSection(&g_context.data_lock);
+    SwitchToThread();
     #else
-    pthread_mutex_destroy(&g_context.data_lock);
+    sched_yield();
     #endif
+}
+
+/**
+ * Wait in the spin window around the predicted packet, then sleep until the
+ * next one. Returns the received length like recvfrom.
+ */
+static int wait_hybrid(RSI_Context* ctx, struct sockaddr_in* robot_addr) {
+    uint64_t window = ctx->config.hybrid_spin_us;
+    uint64_t now = get_time_us();
     
-    if (g_context.config.verbose) {
-        printf("RSI: System optimizations cleaned up\n");
+    uint64_t cycle = ctx->cycle_estimate_ns / 1000;
+    
+    if (ctx->stats.is_connected && cycle > window) {
+        uint64_t expected = ctx->last_arrival_ns / 1000 + cycle;
+        
+        // Sleep through the quiet part of the cycle
+        if (now + window < expected) {
+            if (wait_readable(ctx, expected - window - now)) {
+                return receive_packet(ctx, robot_addr);
+            }
+        }
+        
+        // Spin until the packet arrives or is clearly late
+        while (!ctx->exit_requested && get_time_us() < expected + window) {
+            int recv_len = receive_packet(ctx, robot_addr);
+            if (recv_len > 0) {
+                return recv_len;
+            }
+            yield_thread();
+        }
+    }
+    
+    // No prediction or the packet is overdue
+    if (!wait_readable(ctx, WAKE_TICK_US)) {
+        return 0;
     }
+    return receive_packet(ctx, robot_addr);
 }
 
 /**
- * Initialize network subsystem
+ * Wait for the next packet using the configured strategy
+ */
+static int wait_for_packet(RSI_Context* ctx, struct sockaddr_in* robot_addr) {
+    int recv_len;
+    
+    switch (ctx->config.wait_strategy) {
+        case RSI_WAIT_BLOCKING:
+            // Socket is blocking with a receive timeout of WAKE_TICK_US
+            return receive_packet(ctx, robot_addr);
+        
+        case RSI_WAIT_EPOLL:
+            if (!wait_readable(ctx, WAKE_TICK_US)) {
+                return 0;
+            }
+            return receive_packet(ctx, robot_addr);
+        
+        case RSI_WAIT_HYBRID:
+            return wait_hybrid(ctx, robot_addr);
+        
+        case RSI_WAIT_BUSY_POLL:
+        default:
+            recv_len = receive_packet(ctx, robot_addr);
+            if (recv_len <= 0) {
+                yield_thread();
+            }
+            return recv_len;
+    }
+}
+
+#ifdef __linux__
+#ifndef SCHED_DEADLINE
+    #define SCHED_DEADLINE 6
+#endif
+
+/* Argument of sched_setattr(2), which glibc did not wrap until 2.41 */
+typedef struct {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+} RSI_SchedAttr;
+#endif
+
+/**
+ * Setup result with the given status and no system error
+ */
+static RSI_SetupResult setup_result(RSI_Error status) {
+    RSI_SetupResult result = { status, 0 };
+    return result;
+}
+
+/**
+ * Setup result of a step the system refused
+ */
+static RSI_SetupResult setup_refused(int os_error) {
+    RSI_SetupResult result = { RSI_ERROR_INIT_FAILED, os_error };
+    return result;
+}
+
+/**
+ * Print the outcome of a requested setup step
+ */
+static void report_setup(const char* step, RSI_SetupResult result) {
+    switch (result.status) {
+        case RSI_SUCCESS:
+            printf("RSI: %s applied\n", step);
+            break;
+        case RSI_ERROR_NOT_SUPPORTED:
+            printf("RSI: %s not supported on this platform\n", step);
+            break;
+        case RSI_ERROR_NOT_ENABLED:
+            break;
+        default:
+            printf("RSI: WARNING: %s failed, error: %d\n", step, result.os_error);
+            break;
+    }
+}
+
+/**
+ * Lock all current and future pages of the process in memory
  */
-static RSI_Error init_network(void) {
+static RSI_SetupResult lock_memory(bool requested) {
+    if (!requested) {
+        return setup_result(RSI_ERROR_NOT_ENABLED);
+    }
+    
     #ifdef _WIN32
-    WSADATA wsa_data;
-    int result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
-    if (result != 0) {
-        if (g_context.config.verbose) {
-            printf("RSI: WSAStartup failed with error: %d\n", result);
+    return setup_result(RSI_ERROR_NOT_SUPPORTED);
+    #else
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        return setup_refused(errno);
+    }
+    RSI_STORE_RELAXED(&g_memory_locked, true);
+    return setup_result(RSI_SUCCESS);
+    #endif
+}
+
+/**
+ * Restrict the calling thread to the CPUs in mask
+ */
+static RSI_SetupResult apply_affinity(uint64_t mask) {
+    if (mask == 0) {
+        return setup_result(RSI_ERROR_NOT_ENABLED);
+    }
+    
+    #ifdef _WIN32
+    if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)mask) == 0) {
+        return setup_refused((int)GetLastError());
+    }
+    return setup_result(RSI_SUCCESS);
+    #elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; cpu++) {
+        if (mask & (1ULL << cpu)) {
+            CPU_SET(cpu, &set);
         }
-        return RSI_ERROR_INIT_FAILED;
     }
     
-    if (g_context.config.verbose) {
-        printf("RSI: Windows Sockets initialized successfully\n");
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        return setup_refused(err);
     }
+    return setup_result(RSI_SUCCESS);
     #else
-    if (g_context.config.verbose) {
-        printf("RSI: POSIX Sockets ready\n");
+    return setup_result(RSI_ERROR_NOT_SUPPORTED);
+    #endif
+}
+
+/**
+ * Apply a real-time scheduling policy to the calling thread
+ */
+static RSI_SetupResult apply_scheduling(RSI_SchedPolicy policy, uint32_t priority,
+                                        uint32_t runtime_us, uint32_t period_us) {
+    if (policy == RSI_SCHED_OTHER) {
+        return setup_result(RSI_ERROR_NOT_ENABLED);
+    }
+    
+    #ifdef _WIN32
+    (void)priority;
+    (void)runtime_us;
+    (void)period_us;
+    if (policy == RSI_SCHED_DEADLINE) {
+        return setup_result(RSI_ERROR_NOT_SUPPORTED);
+    }
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        return setup_refused((int)GetLastError());
+    }
+    return setup_result(RSI_SUCCESS);
+    #else
+    if (policy == RSI_SCHED_DEADLINE) {
+        #if defined(__linux__) && defined(SYS_sched_setattr)
+        RSI_SchedAttr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.sched_policy = SCHED_DEADLINE;
+        attr.sched_runtime = (uint64_t)runtime_us * 1000;
+        attr.sched_deadline = (uint64_t)period_us * 1000;
+        attr.sched_period = (uint64_t)period_us * 1000;
+        
+        if (syscall(SYS_sched_setattr, 0, &attr, 0) != 0) {
+            return setup_refused(errno);
+        }
+        return setup_result(RSI_SUCCESS);
+        #else
+        (void)runtime_us;
+        (void)period_us;
+        return setup_result(RSI_ERROR_NOT_SUPPORTED);
+        #endif
+    }
+    
+    int native_policy = policy == RSI_SCHED_RR ? SCHED_RR : SCHED_FIFO;
+    struct sched_param schedParam;
+    schedParam.sched_priority = priority ? (int)priority : sched_get_priority_max(native_policy);
+    
+    int err = pthread_setschedparam(pthread_self(), native_policy, &schedParam);
+    if (err != 0) {
+        return setup_refused(err);
     }
+    return setup_result(RSI_SUCCESS);
     #endif
+}
+
+/**
+ * Touch the top of the calling thread's stack so that deep calls later on
+ * cannot page-fault. The pages stay mapped after this function returns.
+ */
+static RSI_SetupResult prefault_stack(uint32_t kb) {
+    if (kb == 0) {
+        return setup_result(RSI_ERROR_NOT_ENABLED);
+    }
     
-    return RSI_SUCCESS;
+    size_t size = (size_t)kb * 1024;
+    volatile unsigned char* stack = alloca(size);
+    for (size_t offset = 0; offset < size; offset += STACK_TOUCH_STRIDE) {
+        stack[offset] = 0;
+    }
+    stack[size - 1] = 0;
+    
+    return setup_result(RSI_SUCCESS);
+}
+
+#ifndef _WIN32
+/**
+ * Start a library thread. Once the process is memory-locked, every page of a
+ * new stack is locked up front, and the 8 MB default stack alone would
+ * exceed the usual RLIMIT_MEMLOCK, so the stack is kept small.
+ */
+static int create_thread(pthread_t* thread, void* (*func)(void*), void* arg) {
+    pthread_attr_t attr;
+    
+    pthread_attr_init(&attr);
+    if (RSI_LOAD_RELAXED(&g_memory_locked)) {
+        pthread_attr_setstacksize(&attr, LOCKED_STACK_SIZE);
+    }
+    
+    int err = pthread_create(thread, &attr, func, arg);
+    pthread_attr_destroy(&attr);
+    return err;
+}
+#endif
+
+/**
+ * CPU the calling thread runs on, -1 if unknown
+ */
+static int current_cpu(void) {
+    #ifdef _WIN32
+    return (int)GetCurrentProcessorNumber();
+    #elif defined(__linux__)
+    return sched_getcpu();
+    #else
+    return -1;
+    #endif
+}
+
+/**
+ * Network thread function
+ */
+#ifdef _WIN32
+static unsigned __stdcall network_thread_func(void* param) {
+#else
+static void* network_thread_func(void* param) {
+#endif
+    RSI_Context* ctx = param;
+    RSI_StartupDiagnostics* diagnostics = &ctx->diagnostics;
+    struct sockaddr_in robot_addr;
+    int recv_len;
+    
+    // Pin first: a SCHED_DEADLINE thread may not change its affinity. Pinning
+    // itself makes SCHED_DEADLINE fail outside an exclusive cpuset (see init_context)
+    diagnostics->affinity = apply_affinity(ctx->config.cpu_mask);
+    diagnostics->scheduling = apply_scheduling(ctx->config.sched_policy, ctx->config.sched_priority,
+                                               ctx->config.deadline_runtime_us,
+                                               ctx->config.deadline_period_us);
+    diagnostics->stack_prefault = prefault_stack(ctx->config.prefault_stack_kb);
+    diagnostics->cpu = current_cpu();
+    
+    if (ctx->config.verbose) {
+        report_setup("CPU affinity", diagnostics->affinity);
+        report_setup("Real-time scheduling", diagnostics->scheduling);
+        report_setup("Stack prefault", diagnostics->stack_prefault);
+        printf("RSI: Network thread started on CPU %d\n", diagnostics->cpu);
+    }
+    
+    // Let RSI_Start return
+    RSI_STORE_RELEASE(&ctx->thread_ready, true);
+    rsi_signal_notify(&ctx->cycle_signal);
+    
+    while (!ctx->exit_requested) {
+        // Receive packet with the configured wait strategy
+        recv_len = wait_for_packet(ctx, &robot_addr);
+        
+        if (recv_len > 0) {
+            // Null-terminate received data
+            ctx->recv_data[recv_len] = '\0';
+            
+            // Process and respond
+            process_packet(ctx, ctx->recv_data, recv_len, &robot_addr);
+        }
+        
+        // Check for connection timeout
+        check_connection_timeout(ctx);
+    }
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Network thread exiting\n");
+    }
+    
+    return 0;
+}
+
+/**
+ * Print the warnings the network thread traced since the last call. The
+ * network thread never prints itself: a blocked terminal would stall it.
+ */
+static void print_trace_warnings(RSI_Context* ctx) {
+    RSI_TraceRecord records[TRACE_PRINT_BATCH];
+    uint64_t lost = 0;
+    size_t count;
+    
+    while ((count = rsi_trace_read(&ctx->trace, &ctx->trace_printed, records,
+                                   TRACE_PRINT_BATCH, &lost)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            const RSI_TraceRecord* record = &records[i];
+            
+            switch (record->event) {
+                case RSI_TRACE_SLOW_RESPONSE:
+                    printf("WARNING: Slow response: %.3f ms (IPOC %u)\n",
+                           (double)record->args[0] / 1000000.0, record->ipoc);
+                    break;
+                case RSI_TRACE_LATE_RESPONSE:
+                    printf("WARNING: Late response: %.3f ms after kernel receive (%.3f ms before processing)\n",
+                           (double)record->args[0] / 1000000.0, (double)record->args[1] / 1000000.0);
+                    break;
+                case RSI_TRACE_CONNECTION_TIMEOUT:
+                    printf("RSI: Connection timeout after %u ms\n", (unsigned)record->args[0]);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    
+    if (lost > 0) {
+        printf("RSI: %llu trace events overwritten before they were printed\n",
+               (unsigned long long)lost);
+    }
+}
+
+/**
+ * Gap thread function: runs the gap callback and prints traced warnings,
+ * at normal priority
+ */
+#ifdef _WIN32
+static unsigned __stdcall gap_thread_func(void* param) {
+#else
+static void* gap_thread_func(void* param) {
+#endif
+    RSI_Context* ctx = param;
+    RSI_IpocGap gap;
+    
+    for (;;) {
+        uint32_t seen = rsi_signal_sequence(&ctx->gap_signal);
+        
+        while (rsi_ring_read(&ctx->gap_events, &gap, 1) == 1) {
+            ctx->gap_callback(&gap, ctx->gap_user_data);
+        }
+        
+        if (ctx->config.verbose) {
+            print_trace_warnings(ctx);
+        }
+        
+        // Events found before the network thread stopped are still delivered
+        if (RSI_LOAD_ACQUIRE(&ctx->gap_exit)) {
+            break;
+        }
+        rsi_signal_wait(&ctx->gap_signal, seen, WAKE_TICK_US);
+    }
+    
+    return 0;
+}
+
+/**
+ * Start the gap thread if a gap callback is set or verbose output is on
+ */
+static bool start_gap_thread(RSI_Context* ctx) {
+    if (!ctx->gap_callback && !ctx->config.verbose) {
+        return true;
+    }
+    
+    ctx->gap_exit = false;
+    ctx->trace_printed = rsi_trace_position(&ctx->trace);
+    
+    #ifdef _WIN32
+    ctx->gap_thread = (HANDLE)_beginthreadex(NULL, 0, gap_thread_func, ctx, 0, NULL);
+    if (ctx->gap_thread == NULL) {
+        return false;
+    }
+    #else
+    if (create_thread(&ctx->gap_thread, gap_thread_func, ctx) != 0) {
+        return false;
+    }
+    #endif
+    
+    ctx->gap_thread_running = true;
+    return true;
+}
+
+/**
+ * Stop the gap thread after it has delivered the remaining gaps; call after
+ * the network thread has stopped
+ */
+static void stop_gap_thread(RSI_Context* ctx) {
+    if (!ctx->gap_thread_running) {
+        return;
+    }
+    
+    RSI_STORE_RELEASE(&ctx->gap_exit, true);
+    rsi_signal_notify(&ctx->gap_signal);
+    
+    #ifdef _WIN32
+    WaitForSingleObject(ctx->gap_thread, INFINITE);
+    CloseHandle(ctx->gap_thread);
+    ctx->gap_thread = NULL;
+    #else
+    pthread_join(ctx->gap_thread, NULL);
+    #endif
+    
+    ctx->gap_thread_running = false;
+}
+
+/**
+ * Close the socket and the descriptors that watch it
+ */
+static void close_socket(RSI_Context* ctx) {
+    #ifdef __linux__
+    if (ctx->epoll_fd >= 0) {
+        close(ctx->epoll_fd);
+        ctx->epoll_fd = -1;
+    }
+    #endif
+    CLOSE_SOCKET(ctx->sock);
+}
+
+#ifndef _WIN32
+/**
+ * Ask the kernel to timestamp received (and on Linux, sent) datagrams
+ */
+static void enable_timestamps(RSI_Context* ctx) {
+    ctx->rx_timestamps = false;
+    ctx->tx_timestamps = false;
+    ctx->tx_key = 0;
+    
+    if (!ctx->config.kernel_timestamps) {
+        return;
+    }
+    
+    #ifdef __linux__
+    // Software timestamps work on every driver, including loopback
+    int flags = SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_RX_SOFTWARE;
+    int tx_flags = SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    int on = 1;
+    
+    if (setsockopt(ctx->sock, SOL_SOCKET, SO_TIMESTAMPING, &(int){ flags | tx_flags }, sizeof(int)) == 0) {
+        ctx->rx_timestamps = true;
+        ctx->tx_timestamps = true;
+    } else if (setsockopt(ctx->sock, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0 ||
+               setsockopt(ctx->sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0) {
+        ctx->rx_timestamps = true;
+    }
+    #else
+    int on = 1;
+    if (setsockopt(ctx->sock, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) == 0) {
+        ctx->rx_timestamps = true;
+    }
+    #endif
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Kernel timestamps: receive %s, send %s\n",
+               ctx->rx_timestamps ? "on" : "unavailable",
+               ctx->tx_timestamps ? "on" : "unavailable");
+    }
+}
+#endif
+
+/**
+ * Create and configure socket for minimal latency
+ */
+static RSI_Error create_optimized_socket(RSI_Context* ctx, const char* local_ip, uint16_t local_port) {
+    struct sockaddr_in local_addr;
+    int reuse = 1;
+    
+    // Create UDP socket
+    ctx->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (ctx->sock == INVALID_SOCKET_VALUE) {
+        if (ctx->config.verbose) {
+            printf("RSI: Failed to create socket, error: %d\n", GET_SOCKET_ERROR);
+        }
+        return RSI_ERROR_SOCKET_FAILED;
+    }
+    
+    // Allow address reuse
+    if (setsockopt(ctx->sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse)) < 0) {
+        if (ctx->config.verbose) {
+            printf("RSI: setsockopt(SO_REUSEADDR) failed, error: %d\n", GET_SOCKET_ERROR);
+        }
+    }
+    
+    // Set large socket buffers
+    int rcvbuf_size = 1048576;  // 1MB
+    int sndbuf_size = 1048576;  // 1MB
+    
+    if (setsockopt(ctx->sock, SOL_SOCKET, SO_RCVBUF, (const char*)&rcvbuf_size, sizeof(rcvbuf_size)) < 0) {
+        if (ctx->config.verbose) {
+            printf("RSI: setsockopt(SO_RCVBUF) failed, error: %d\n", GET_SOCKET_ERROR);
+        }
+    }
+    
+    if (setsockopt(ctx->sock, SOL_SOCKET, SO_SNDBUF, (const char*)&sndbuf_size, sizeof(sndbuf_size)) < 0) {
+        if (ctx->config.verbose) {
+            printf("RSI: setsockopt(SO_SNDBUF) failed, error: %d\n", GET_SOCKET_ERROR);
+        }
+    }
+    
+    // Set up local address
+    memset(&local_addr, 0, sizeof(local_addr));
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_port = htons(local_port);
+    
+    if (strcmp(local_ip, "0.0.0.0") == 0) {
+        local_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    } else {
+        local_addr.sin_addr.s_addr = inet_addr(local_ip);
+    }
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Binding to %s:%d\n", local_ip, local_port);
+    }
+    
+    // Bind socket to local address
+    if (bind(ctx->sock, (struct sockaddr*)&local_addr, sizeof(local_addr)) == SOCKET_ERROR_CODE) {
+        if (ctx->config.verbose) {
+            printf("RSI: Bind failed, error: %d\n", GET_SOCKET_ERROR);
+        }
+        CLOSE_SOCKET(ctx->sock);
+        return RSI_ERROR_SOCKET_FAILED;
+    }
+    
+    #ifndef _WIN32
+    for (int i = 0; i < RECV_BATCH; i++) {
+        ctx->recv_iov[i].iov_base = ctx->recv_buffers[i];
+        ctx->recv_iov[i].iov_len = MAX_BUFFER_SIZE - 1;
+    }
+    
+    enable_timestamps(ctx);
+    #endif
+    
+    #ifdef __linux__
+    ctx->epoll_fd = -1;
+    
+    // Receive batch for recvmmsg
+    memset(ctx->recv_msgs, 0, sizeof(ctx->recv_msgs));
+    for (int i = 0; i < RECV_BATCH; i++) {
+        ctx->recv_msgs[i].msg_hdr.msg_iov = &ctx->recv_iov[i];
+        ctx->recv_msgs[i].msg_hdr.msg_iovlen = 1;
+        ctx->recv_msgs[i].msg_hdr.msg_name = &ctx->recv_addrs[i];
+        ctx->recv_msgs[i].msg_hdr.msg_control = ctx->recv_control[i];
+    }
+    
+    // Let the kernel poll the device queue before sleeping in receive or epoll
+    if (ctx->config.busy_poll_us > 0) {
+        int busy_poll = (int)ctx->config.busy_poll_us;
+        if (setsockopt(ctx->sock, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) < 0) {
+            if (ctx->config.verbose) {
+                printf("RSI: setsockopt(SO_BUSY_POLL) failed, error: %d\n", errno);
+            }
+        }
+    }
+    #endif
+    
+    // A blocking socket wakes up every WAKE_TICK_US to check for exit and timeouts
+    if (ctx->config.wait_strategy == RSI_WAIT_BLOCKING && !ctx->server) {
+        #ifdef _WIN32
+        DWORD timeout = WAKE_TICK_US / 1000;
+        #else
+        struct timeval timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_usec = WAKE_TICK_US;
+        #endif
+        if (setsockopt(ctx->sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout)) < 0) {
+            if (ctx->config.verbose) {
+                printf("RSI: setsockopt(SO_RCVTIMEO) failed, error: %d\n", GET_SOCKET_ERROR);
+            }
+            CLOSE_SOCKET(ctx->sock);
+            return RSI_ERROR_SOCKET_FAILED;
+        }
+        
+        if (ctx->config.verbose) {
+            printf("RSI: Socket configured for blocking receive\n");
+        }
+        return RSI_SUCCESS;
+    }
+    
+    // Set socket to non-blocking mode
+    #ifdef _WIN32
+    u_long mode = 1;
+    if (ioctlsocket(ctx->sock, FIONBIO, &mode) == SOCKET_ERROR) {
+        if (ctx->config.verbose) {
+            printf("RSI: ioctlsocket failed with error: %d\n", GET_SOCKET_ERROR);
+        }
+        CLOSE_SOCKET(ctx->sock);
+        return RSI_ERROR_SOCKET_FAILED;
+    }
+    #else
+    int flags = fcntl(ctx->sock, F_GETFL, 0);
+    if (flags < 0 || fcntl(ctx->sock, F_SETFL, flags | O_NONBLOCK) < 0) {
+        if (ctx->config.verbose) {
+            printf("RSI: fcntl failed with error: %d\n", errno);
+        }
+        CLOSE_SOCKET(ctx->sock);
+        return RSI_ERROR_SOCKET_FAILED;
+    }
+    #endif
+    
+    #ifdef __linux__
+    if (ctx->config.wait_strategy == RSI_WAIT_EPOLL && !ctx->server) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        
+        ctx->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (ctx->epoll_fd < 0 ||
+            epoll_ctl(ctx->epoll_fd, EPOLL_CTL_ADD, ctx->sock, &event) < 0) {
+            if (ctx->config.verbose) {
+                printf("RSI: epoll setup failed with error: %d\n", errno);
+            }
+            close_socket(ctx);
+            return RSI_ERROR_SOCKET_FAILED;
+        }
+    }
+    #endif
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Socket configured for minimal latency\n");
+    }
+    
+    return RSI_SUCCESS;
+}
+
+/**
+ * Create the socket on the configured address
+ */
+static RSI_Error open_socket(RSI_Context* ctx) {
+    const char* local_ip = ctx->config.local_ip ? ctx->config.local_ip : DEFAULT_LOCAL_IP;
+    uint16_t local_port = ctx->config.local_port ? ctx->config.local_port : DEFAULT_PORT;
+    
+    return create_optimized_socket(ctx, local_ip, local_port);
+}
+
+/**
+ * Initialize system optimizations
+ */
+static void init_system_optimizations(RSI_Context* ctx) {
+    // Set Windows timer resolution to 1ms
+    #ifdef _WIN32
+    timeBeginPeriod(1);
+    #endif
+    
+    // Initialize synchronization primitives
+    #ifdef _WIN32
+    InitializeCriticalSectionAndSpinCount(&ctx->correction_lock, 4000);
+    InitializeCriticalSection(&ctx->window_lock);
+    #else
+    pthread_mutex_init(&ctx->correction_lock, NULL);
+    pthread_mutex_init(&ctx->window_lock, NULL);
+    #endif
+    rsi_signal_init(&ctx->cycle_signal);
+    rsi_signal_init(&ctx->gap_signal);
+    ctx->event_fd = -1;
+    
+    // Set process priority to high
+    #ifdef _WIN32
+    SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+    #endif
+    
+    // Keep page faults out of the cycle
+    ctx->diagnostics.memory_lock = lock_memory(ctx->config.lock_memory);
+    
+    if (ctx->config.verbose) {
+        report_setup("Memory lock", ctx->diagnostics.memory_lock);
+        printf("RSI: System optimizations applied\n");
+    }
+}
+
+/**
+ * Clean up system optimizations
+ */
+static void cleanup_system_optimizations(RSI_Context* ctx) {
+    // Reset Windows timer resolution
+    #ifdef _WIN32
+    timeEndPeriod(1);
+    #endif
+    
+    // Clean up synchronization primitives
+    #ifdef _WIN32
+    DeleteCriticalSection(&ctx->correction_lock);
+    DeleteCriticalSection(&ctx->window_lock);
+    #else
+    pthread_mutex_destroy(&ctx->correction_lock);
+    pthread_mutex_destroy(&ctx->window_lock);
+    #endif
+    rsi_signal_destroy(&ctx->cycle_signal);
+    rsi_signal_destroy(&ctx->gap_signal);
+    
+    #ifdef __linux__
+    if (ctx->event_fd >= 0) {
+        close(ctx->event_fd);
+        ctx->event_fd = -1;
+    }
+    #endif
+    
+    if (ctx->config.verbose) {
+        printf("RSI: System optimizations cleaned up\n");
+    }
+}
+
+/**
+ * Initialize network subsystem
+ */
+static RSI_Error init_network(RSI_Context* ctx) {
+    #ifdef _WIN32
+    WSADATA wsa_data;
+    int result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
+    if (result != 0) {
+        if (ctx->config.verbose) {
+            printf("RSI: WSAStartup failed with error: %d\n", result);
+        }
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Windows Sockets initialized successfully\n");
+    }
+    #else
+    if (ctx->config.verbose) {
+        printf("RSI: POSIX Sockets ready\n");
+    }
+    #endif
+    
+    return RSI_SUCCESS;
+}
+
+/* Instance lifecycle */
+
+/**
+ * Mark the network thread setup steps as not applied yet
+ */
+static void reset_thread_diagnostics(RSI_Context* ctx) {
+    ctx->diagnostics.affinity = setup_result(RSI_ERROR_NOT_ENABLED);
+    ctx->diagnostics.scheduling = setup_result(RSI_ERROR_NOT_ENABLED);
+    ctx->diagnostics.stack_prefault = setup_result(RSI_ERROR_NOT_ENABLED);
+    ctx->diagnostics.cpu = -1;
+}
+
+static RSI_Error init_context(RSI_Context* ctx, const RSI_Config* config) {
+    // Check if already initialized
+    if (ctx->initialized) {
+        return RSI_ERROR_ALREADY_RUNNING;
+    }
+    
+    // Clear context
+    bool allocated = ctx->allocated;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->allocated = allocated;
+    
+    // Initialize stats with default values
+    ctx->stats.min_response_time_ms = 9999.0;
+    ctx->late_threshold_ms = DEFAULT_CYCLE_MS;
+    publish_frame(ctx);
+    
+    // Set configuration (use defaults if NULL)
+    if (config) {
+        memcpy(&ctx->config, config, sizeof(RSI_Config));
+    } else {
+        ctx->config.local_ip = DEFAULT_LOCAL_IP;
+        ctx->config.local_port = DEFAULT_PORT;
+        ctx->config.timeout_ms = DEFAULT_TIMEOUT_MS;
+        ctx->config.verbose = false;
+    }
+    
+    // Validate the underrun policy of the correction queue
+    if (ctx->config.underrun_decay == 0.0) {
+        ctx->config.underrun_decay = DEFAULT_UNDERRUN_DECAY;
+    }
+    if (ctx->config.underrun_mode > RSI_UNDERRUN_DECAY ||
+        !(ctx->config.underrun_decay > 0.0 && ctx->config.underrun_decay < 1.0)) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Validate the wait strategy of the network thread
+    if (ctx->config.wait_strategy > RSI_WAIT_HYBRID) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    if (ctx->config.hybrid_spin_us == 0) {
+        ctx->config.hybrid_spin_us = DEFAULT_HYBRID_SPIN_US;
+    }
+    
+    // Validate the real-time setup of the network thread
+    if (ctx->config.deadline_runtime_us == 0) {
+        ctx->config.deadline_runtime_us = DEFAULT_DEADLINE_RUNTIME_US;
+    }
+    if (ctx->config.deadline_period_us == 0) {
+        ctx->config.deadline_period_us = DEFAULT_DEADLINE_PERIOD_US;
+    }
+    if (ctx->config.sched_policy > RSI_SCHED_OTHER ||
+        ctx->config.sched_priority > 99 ||
+        ctx->config.deadline_runtime_us > ctx->config.deadline_period_us ||
+        ctx->config.prefault_stack_kb > MAX_PREFAULT_STACK_KB) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // SCHED_DEADLINE is admitted per root domain; pinned to fewer CPUs, the
+    // thread is refused with EPERM unless they form an exclusive cpuset
+    #ifdef __linux__
+    if (ctx->config.verbose && ctx->config.sched_policy == RSI_SCHED_DEADLINE && ctx->config.cpu_mask != 0 &&
+        __builtin_popcountll(ctx->config.cpu_mask) < sysconf(_SC_NPROCESSORS_ONLN)) {
+        printf("RSI: Warning: SCHED_DEADLINE with cpu_mask fails unless the CPUs form an exclusive cpuset\n");
+    }
+    #endif
+    reset_thread_diagnostics(ctx);
+    
+    // Apply system optimizations
+    init_system_optimizations(ctx);
+    
+    // Pre-render the zero-correction response
+    RSI_CartesianCorrection zero_correction = {0};
+    publish_correction(ctx, &zero_correction);
+    ctx->zero_response = ctx->responses[ctx->response_generation & 1];
+    ctx->held_response = ctx->zero_response;
+    ctx->held_generation = ctx->response_generation;
+    
+    // Select the packet scanner for this CPU
+    const RSI_ScanImplementation* scanner = rsi_scan_active();
+    if (ctx->config.verbose) {
+        printf("RSI: Using %s structural scanner\n", scanner->name);
+    }
+    
+    // Select and calibrate the tick counter before the first packet
+    ctx->tick_ns = rsi_clock_tick_ns();
+    if (ctx->config.verbose) {
+        printf("RSI: Using %s clock (%.3f ns per tick)\n", rsi_clock_name(), ctx->tick_ns);
+    }
+    
+    // Allocate the sample ring if requested
+    if (ctx->config.sample_ring_size > 0 &&
+        !rsi_ring_init(&ctx->samples, ctx->config.sample_ring_size, sizeof(RSI_Sample))) {
+        if (ctx->config.verbose) {
+            printf("RSI: Failed to allocate sample ring\n");
+        }
+        cleanup_system_optimizations(ctx);
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    // Allocate the correction queue if requested
+    if (ctx->config.correction_queue_size > 0 &&
+        !rsi_ring_init(&ctx->correction_queue, ctx->config.correction_queue_size,
+                       sizeof(RSI_RenderedResponse))) {
+        if (ctx->config.verbose) {
+            printf("RSI: Failed to allocate correction queue\n");
+        }
+        rsi_ring_free(&ctx->samples);
+        cleanup_system_optimizations(ctx);
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    // Allocate the gap reports for the gap callback
+    if (!rsi_ring_init(&ctx->gap_events, GAP_EVENT_CAPACITY, sizeof(RSI_IpocGap))) {
+        if (ctx->config.verbose) {
+            printf("RSI: Failed to allocate gap reports\n");
+        }
+        rsi_ring_free(&ctx->correction_queue);
+        rsi_ring_free(&ctx->samples);
+        cleanup_system_optimizations(ctx);
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    // Allocate the event trace
+    uint32_t trace_records = ctx->config.trace_records ? ctx->config.trace_records : DEFAULT_TRACE_RECORDS;
+    if (!rsi_trace_init(&ctx->trace, trace_records, get_time_ns())) {
+        if (ctx->config.verbose) {
+            printf("RSI: Failed to allocate event trace\n");
+        }
+        rsi_ring_free(&ctx->gap_events);
+        rsi_ring_free(&ctx->correction_queue);
+        rsi_ring_free(&ctx->samples);
+        cleanup_system_optimizations(ctx);
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    // Allocate the stage histograms if requested
+    if (ctx->config.stage_timing) {
+        ctx->stage_histograms = rsi_aligned_zalloc(RSI_STAGE_COUNT * sizeof(RSI_Histogram));
+        if (!ctx->stage_histograms) {
+            if (ctx->config.verbose) {
+                printf("RSI: Failed to allocate stage histograms\n");
+            }
+            rsi_trace_free(&ctx->trace);
+            rsi_ring_free(&ctx->gap_events);
+            rsi_ring_free(&ctx->correction_queue);
+            rsi_ring_free(&ctx->samples);
+            cleanup_system_optimizations(ctx);
+            return RSI_ERROR_INIT_FAILED;
+        }
+    }
+    
+    // Map the telemetry segment if requested
+    if (ctx->config.telemetry_name) {
+        int os_error;
+        ctx->telemetry = rsi_telemetry_create(ctx->config.telemetry_name, ctx->stage_histograms != NULL,
+                                              ctx->tick_ns, &os_error);
+        if (!ctx->telemetry) {
+            if (ctx->config.verbose) {
+                printf("RSI: Failed to create telemetry segment %s, error: %d\n",
+                       ctx->config.telemetry_name, os_error);
+            }
+            rsi_aligned_free(ctx->stage_histograms);
+            rsi_trace_free(&ctx->trace);
+            rsi_ring_free(&ctx->gap_events);
+            rsi_ring_free(&ctx->correction_queue);
+            rsi_ring_free(&ctx->samples);
+            cleanup_system_optimizations(ctx);
+            return RSI_ERROR_INIT_FAILED;
+        }
+        
+        if (ctx->config.verbose) {
+            printf("RSI: Publishing telemetry to %s\n", ctx->config.telemetry_name);
+        }
+    }
+    
+    // Initialize network
+    RSI_Error err = init_network(ctx);
+    if (err != RSI_SUCCESS) {
+        rsi_telemetry_destroy(ctx->telemetry);
+        ctx->telemetry = NULL;
+        rsi_aligned_free(ctx->stage_histograms);
+        rsi_trace_free(&ctx->trace);
+        rsi_ring_free(&ctx->gap_events);
+        rsi_ring_free(&ctx->correction_queue);
+        rsi_ring_free(&ctx->samples);
+        cleanup_system_optimizations(ctx);
+        return err;
+    }
+    
+    ctx->initialized = true;
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_SetCallbacksH(RSI_Handle ctx,
+                          RSI_DataCallback data_callback,
+                          RSI_ConnectionCallback connection_callback,
+                          void* user_data) {
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (ctx->running) {
+        return RSI_ERROR_ALREADY_RUNNING;
+    }
+    
+    ctx->data_callback = data_callback;
+    ctx->connection_callback = connection_callback;
+    ctx->callback_user_data = user_data;
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_SetGapCallbackH(RSI_Handle ctx, RSI_GapCallback gap_callback, void* user_data) {
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (ctx->running) {
+        return RSI_ERROR_ALREADY_RUNNING;
+    }
+    
+    ctx->gap_callback = gap_callback;
+    ctx->gap_user_data = user_data;
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_StartH(RSI_Handle ctx) {
+    RSI_Error err;
+    
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    // Check if already running
+    if (ctx->running) {
+        return RSI_ERROR_ALREADY_RUNNING;
+    }
+    
+    // Instances attached to a server are started by RSI_ServerStart
+    if (ctx->server) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Create and configure socket
+    err = open_socket(ctx);
+    if (err != RSI_SUCCESS) {
+        return err;
+    }
+    
+    // Initialize exit flag
+    ctx->exit_requested = false;
+    ctx->thread_ready = false;
+    reset_thread_diagnostics(ctx);
+    
+    // Start the gap thread first so gaps are never reported to nobody
+    if (!start_gap_thread(ctx)) {
+        if (ctx->config.verbose) {
+            printf("RSI: Failed to create gap thread\n");
+        }
+        close_socket(ctx);
+        return RSI_ERROR_THREAD_FAILED;
+    }
+    
+    // Start network thread
+    #ifdef _WIN32
+    ctx->network_thread = (HANDLE)_beginthreadex(NULL, 0, network_thread_func, ctx, 0, NULL);
+    if (ctx->network_thread == NULL) {
+        if (ctx->config.verbose) {
+            printf("RSI: Failed to create network thread\n");
+        }
+        stop_gap_thread(ctx);
+        close_socket(ctx);
+        return RSI_ERROR_THREAD_FAILED;
+    }
+    #else
+    if (create_thread(&ctx->network_thread, network_thread_func, ctx) != 0) {
+        if (ctx->config.verbose) {
+            printf("RSI: Failed to create network thread\n");
+        }
+        stop_gap_thread(ctx);
+        close_socket(ctx);
+        return RSI_ERROR_THREAD_FAILED;
+    }
+    #endif
+    
+    // Wait until the network thread has applied its real-time setup
+    for (;;) {
+        uint32_t seen = rsi_signal_sequence(&ctx->cycle_signal);
+        if (RSI_LOAD_ACQUIRE(&ctx->thread_ready)) {
+            break;
+        }
+        rsi_signal_wait(&ctx->cycle_signal, seen, WAKE_TICK_US);
+    }
+    
+    ctx->running = true;
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Started successfully\n");
+    }
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_StopH(RSI_Handle ctx) {
+    // Check if initialized and running
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!ctx->running) {
+        return RSI_ERROR_NOT_RUNNING;
+    }
+    
+    // Instances attached to a server are stopped by RSI_ServerStop
+    if (ctx->server) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Signal thread to exit
+    ctx->exit_requested = true;
+    
+    // Wait for thread to exit
+    #ifdef _WIN32
+    WaitForSingleObject(ctx->network_thread, 1000);
+    CloseHandle(ctx->network_thread);
+    ctx->network_thread = NULL;
+    #else
+    pthread_join(ctx->network_thread, NULL);
+    #endif
+    
+    stop_gap_thread(ctx);
+    
+    // Close socket
+    close_socket(ctx);
+    
+    // Release RSI_WaitForCycle callers
+    RSI_STORE_RELEASE(&ctx->running, false);
+    rsi_signal_notify(&ctx->cycle_signal);
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Stopped successfully\n");
+    }
+    
+    return RSI_SUCCESS;
+}
+
+static RSI_Error cleanup_context(RSI_Context* ctx) {
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    // The server still references the instance until RSI_ServerDestroy
+    if (ctx->server) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Stop if still running
+    if (ctx->running) {
+        RSI_Error err = RSI_StopH(ctx);
+        if (err != RSI_SUCCESS) {
+            return err;
+        }
+    }
+    
+    // Clean up network
+    #ifdef _WIN32
+    WSACleanup();
+    #endif
+    
+    // Clean up system optimizations
+    cleanup_system_optimizations(ctx);
+    
+    // Release the sample ring, correction queue, gap reports and trace
+    rsi_ring_free(&ctx->samples);
+    rsi_ring_free(&ctx->correction_queue);
+    rsi_ring_free(&ctx->gap_events);
+    rsi_trace_free(&ctx->trace);
+    rsi_aligned_free(ctx->stage_histograms);
+    ctx->stage_histograms = NULL;
+    
+    // Readers see the segment close
+    rsi_telemetry_destroy(ctx->telemetry);
+    ctx->telemetry = NULL;
+    
+    ctx->initialized = false;
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Cleaned up successfully\n");
+    }
+    
+    return RSI_SUCCESS;
+}
+
+/* Public API Implementation */
+
+RSI_Error RSI_Create(const RSI_Config* config, RSI_Handle* handle) {
+    if (!handle) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    *handle = NULL;
+    
+    // Cache-line aligned like the static default instance
+    RSI_Context* ctx = rsi_aligned_zalloc(sizeof(RSI_Context));
+    if (!ctx) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    ctx->allocated = true;
+    
+    RSI_Error err = init_context(ctx, config);
+    if (err != RSI_SUCCESS) {
+        rsi_aligned_free(ctx);
+        return err;
+    }
+    
+    *handle = ctx;
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_Destroy(RSI_Handle ctx) {
+    if (!ctx || !ctx->allocated) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    RSI_Error err = cleanup_context(ctx);
+    if (err != RSI_SUCCESS) {
+        return err;
+    }
+    
+    rsi_aligned_free(ctx);
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_GetCartesianPositionH(RSI_Handle ctx, RSI_CartesianPosition* position) {
+    // Check if initialized and running
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!ctx->running) {
+        return RSI_ERROR_NOT_RUNNING;
+    }
+    
+    if (!position) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Copy data from the last published frame
+    RSI_Frame frame;
+    read_frame(ctx, &frame);
+    *position = frame.cartesian;
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_GetJointPositionH(RSI_Handle ctx, RSI_JointPosition* position) {
+    // Check if initialized and running
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!ctx->running) {
+        return RSI_ERROR_NOT_RUNNING;
+    }
+    
+    if (!position) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Copy data from the last published frame
+    RSI_Frame frame;
+    read_frame(ctx, &frame);
+    *position = frame.joints;
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_SetCartesianCorrectionH(RSI_Handle ctx, const RSI_CartesianCorrection* correction) {
+    // Check if initialized and running
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!ctx->running) {
+        return RSI_ERROR_NOT_RUNNING;
+    }
+    
+    if (!correction) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Serialize writers; the network thread never takes this lock
+    #ifdef _WIN32
+    EnterCriticalSection(&ctx->correction_lock);
+    #else
+    pthread_mutex_lock(&ctx->correction_lock);
+    #endif
+    
+    // Render the response now so the network thread only splices the IPOC
+    bool published = publish_correction(ctx, correction);
+    
+    #ifdef _WIN32
+    LeaveCriticalSection(&ctx->correction_lock);
+    #else
+    pthread_mutex_unlock(&ctx->correction_lock);
+    #endif
+    
+    return published ? RSI_SUCCESS : RSI_ERROR_INVALID_PARAM;
+}
+
+RSI_Error RSI_QueueCorrectionsH(RSI_Handle ctx, const RSI_CartesianCorrection* corrections, size_t count, size_t* queued) {
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if ((!corrections && count > 0) || !queued) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    *queued = 0;
+    if (!ctx->correction_queue.slots) {
+        return RSI_ERROR_NOT_ENABLED;
+    }
+    
+    // Serialize with RSI_FlushCorrections, which reads the producer position
+    #ifdef _WIN32
+    EnterCriticalSection(&ctx->correction_lock);
+    #else
+    pthread_mutex_lock(&ctx->correction_lock);
+    #endif
+    
+    RSI_Error result = RSI_SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        RSI_RenderedResponse* entry = rsi_ring_begin_write(&ctx->correction_queue);
+        if (!entry) {
+            break;
+        }
+        
+        // Render on this thread; the network thread only splices the IPOC
+        entry->len = render_response_prefix(&corrections[i], entry->data, sizeof(entry->data));
+        if (entry->len == 0) {
+            result = RSI_ERROR_INVALID_PARAM;
+            break;
+        }
+        entry->correction = corrections[i];
+        
+        rsi_ring_end_write(&ctx->correction_queue);
+        (*queued)++;
+    }
+    
+    #ifdef _WIN32
+    LeaveCriticalSection(&ctx->correction_lock);
+    #else
+    pthread_mutex_unlock(&ctx->correction_lock);
+    #endif
+    
+    return result;
+}
+
+RSI_Error RSI_FlushCorrectionsH(RSI_Handle ctx) {
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!ctx->correction_queue.slots) {
+        return RSI_ERROR_NOT_ENABLED;
+    }
+    
+    #ifdef _WIN32
+    EnterCriticalSection(&ctx->correction_lock);
+    #else
+    pthread_mutex_lock(&ctx->correction_lock);
+    #endif
+    
+    // Only the network thread consumes, so it does the discarding
+    RSI_STORE_RELEASE(&ctx->queue_flush_until,
+                      rsi_ring_write_position(&ctx->correction_queue));
+    
+    #ifdef _WIN32
+    LeaveCriticalSection(&ctx->correction_lock);
+    #else
+    pthread_mutex_unlock(&ctx->correction_lock);
+    #endif
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_GetStatisticsH(RSI_Handle ctx, RSI_Statistics* stats) {
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!stats) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Copy statistics from the last published frame
+    RSI_Frame frame;
+    read_frame(ctx, &frame);
+    *stats = frame.stats;
+    
+    // Percentiles are computed here rather than on the network thread
+    RSI_Percentiles percentiles;
+    if (RSI_GetPercentilesH(ctx, &percentiles) == RSI_SUCCESS) {
+        stats->p50_response_time_ms = percentiles.p50_ms;
+        stats->p99_response_time_ms = percentiles.p99_ms;
+        stats->p999_response_time_ms = percentiles.p999_ms;
+    }
+    
+    if (RSI_GetJitterPercentilesH(ctx, &percentiles) == RSI_SUCCESS) {
+        stats->p50_jitter_ms = percentiles.p50_ms;
+        stats->p99_jitter_ms = percentiles.p99_ms;
+        stats->p999_jitter_ms = percentiles.p999_ms;
+    }
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_GetPercentilesH(RSI_Handle ctx, RSI_Percentiles* percentiles) {
+    RSI_Histogram snapshot;
+    
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!percentiles) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    rsi_histogram_snapshot(&ctx->response_histogram, &snapshot);
+    rsi_histogram_percentiles(&snapshot, NULL, 1e-6, percentiles);
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_GetWindowPercentilesH(RSI_Handle ctx, bool reset, RSI_Percentiles* percentiles) {
+    RSI_Histogram snapshot;
+    
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!percentiles) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    #ifdef _WIN32
+    EnterCriticalSection(&ctx->window_lock);
+    #else
+    pthread_mutex_lock(&ctx->window_lock);
+    #endif
+    
+    rsi_histogram_snapshot(&ctx->response_histogram, &snapshot);
+    rsi_histogram_percentiles(&snapshot, &ctx->window_start, 1e-6, percentiles);
+    
+    // The next window starts exactly where this one ended
+    if (reset) {
+        ctx->window_start = snapshot;
+    }
+    
+    #ifdef _WIN32
+    LeaveCriticalSection(&ctx->window_lock);
+    #else
+    pthread_mutex_unlock(&ctx->window_lock);
+    #endif
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_GetJitterPercentilesH(RSI_Handle ctx, RSI_Percentiles* percentiles) {
+    RSI_Histogram snapshot;
+    
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!percentiles) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    rsi_histogram_snapshot(&ctx->jitter_histogram, &snapshot);
+    rsi_histogram_percentiles(&snapshot, NULL, 1e-6, percentiles);
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_GetStagePercentilesH(RSI_Handle ctx, RSI_Stage stage, RSI_Percentiles* percentiles) {
+    RSI_Histogram snapshot;
+    
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!ctx->stage_histograms) {
+        return RSI_ERROR_NOT_ENABLED;
+    }
+    
+    if ((unsigned)stage >= RSI_STAGE_COUNT || !percentiles) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    rsi_histogram_snapshot(&ctx->stage_histograms[stage], &snapshot);
+    rsi_histogram_percentiles(&snapshot, NULL, ctx->tick_ns * 1e-6, percentiles);
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_GetFrameH(RSI_Handle ctx, RSI_Frame* frame) {
+    // Check if initialized and running
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!ctx->running) {
+        return RSI_ERROR_NOT_RUNNING;
+    }
+    
+    if (!frame) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    read_frame(ctx, frame);
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_WaitForCycleH(RSI_Handle ctx, uint32_t last_ipoc, uint32_t timeout_ms, RSI_Frame* frame) {
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!frame) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    uint64_t deadline = get_time_us() + (uint64_t)timeout_ms * 1000;
+    
+    for (;;) {
+        // Sample the sequence first so a cycle published in between still wakes us
+        uint32_t seen = rsi_signal_sequence(&ctx->cycle_signal);
+        
+        if (!RSI_LOAD_ACQUIRE(&ctx->running)) {
+            return RSI_ERROR_NOT_RUNNING;
+        }
+        
+        read_frame(ctx, frame);
+        if (frame->ipoc != last_ipoc) {
+            return RSI_SUCCESS;
+        }
+        
+        uint64_t now = get_time_us();
+        if (now >= deadline) {
+            return RSI_ERROR_TIMEOUT;
+        }
+        
+        rsi_signal_wait(&ctx->cycle_signal, seen, deadline - now);
+    }
+}
+
+RSI_Error RSI_GetEventFdH(RSI_Handle ctx, int* fd) {
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!fd) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    #ifdef __linux__
+    int current = RSI_LOAD_ACQUIRE(&ctx->event_fd);
+    if (current < 0) {
+        // Created on first use so the network thread only pays for the
+        // write() when someone listens
+        int created = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (created < 0) {
+            return RSI_ERROR_INIT_FAILED;
+        }
+        
+        if (__atomic_compare_exchange_n(&ctx->event_fd, &current, created, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            current = created;
+        } else {
+            close(created);
+        }
+    }
+    
+    *fd = current;
+    return RSI_SUCCESS;
+    #else
+    *fd = -1;
+    return RSI_ERROR_NOT_SUPPORTED;
+    #endif
+}
+
+RSI_Error RSI_GetStartupDiagnosticsH(RSI_Handle ctx, RSI_StartupDiagnostics* diagnostics) {
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!diagnostics) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    *diagnostics = ctx->diagnostics;
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_ReadSamplesH(RSI_Handle ctx, RSI_Sample* samples, size_t max_samples, size_t* count) {
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!samples || !count) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    if (!ctx->samples.slots) {
+        *count = 0;
+        return RSI_ERROR_NOT_ENABLED;
+    }
+    
+    *count = rsi_ring_read(&ctx->samples, samples, max_samples);
+    
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_DumpTraceH(RSI_Handle ctx, const char* path) {
+    RSI_TraceHeader header;
+    
+    // Check if initialized
+    if (!ctx || !ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    
+    if (!path) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    
+    // Copy the whole ring first, so the writer laps it as little as possible
+    size_t capacity = (size_t)ctx->trace.mask + 1;
+    RSI_TraceRecord* records = malloc(capacity * sizeof(RSI_TraceRecord));
+    if (!records) {
+        return RSI_ERROR_UNKNOWN;
+    }
+    
+    uint64_t position = 0;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RSI_TRACE_MAGIC, sizeof(header.magic));
+    header.version = RSI_TRACE_VERSION;
+    header.record_size = sizeof(RSI_TraceRecord);
+    header.record_count = rsi_trace_read(&ctx->trace, &position, records, capacity, &header.lost_records);
+    
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        free(records);
+        return RSI_ERROR_FILE_FAILED;
+    }
+    
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(records, sizeof(RSI_TraceRecord), (size_t)header.record_count, file) == header.record_count;
+    
+    free(records);
+    if (fclose(file) != 0 || !written) {
+        return RSI_ERROR_FILE_FAILED;
+    }
+    
+    if (ctx->config.verbose) {
+        printf("RSI: Wrote %llu trace events to %s\n", (unsigned long long)header.record_count, path);
+    }
+    
+    return RSI_SUCCESS;
+}
+
+/* Sharded event loop */
+
+/**
+ * Answer the newest datagram waiting on a readable socket
+ */
+static void service_socket(RSI_Context* ctx) {
+    struct sockaddr_in robot_addr;
+    int recv_len = receive_packet(ctx, &robot_addr);
+    
+    if (recv_len > 0) {
+        ctx->recv_data[recv_len] = '\0';
+        process_packet(ctx, ctx->recv_data, recv_len, &robot_addr);
+    }
+}
+
+/**
+ * Event-loop thread serving every instance of one shard
+ */
+#ifdef _WIN32
+static unsigned __stdcall shard_thread_func(void* param) {
+#else
+static void* shard_thread_func(void* param) {
+#endif
+    RSI_Shard* shard = param;
+    RSI_Server* server = shard->server;
+    uint64_t next_timeout_check = 0;
+    
+    RSI_StartupDiagnostics* diagnostics = &server->diagnostics[shard->index];
+    int cpu = server->cpus[shard->index];
+    diagnostics->affinity = apply_affinity(cpu >= 0 ? 1ULL << cpu : 0);
+    diagnostics->scheduling = apply_scheduling(server->config.sched_policy, server->config.sched_priority, 0, 0);
+    diagnostics->cpu = current_cpu();
+    
+    if (server->config.verbose) {
+        report_setup("CPU affinity", diagnostics->affinity);
+        report_setup("Real-time scheduling", diagnostics->scheduling);
+        printf("RSI: Event loop %u started with %u robots on CPU %d\n",
+               shard->index, (unsigned)shard->member_count, diagnostics->cpu);
+    }
+    
+    // Let RSI_ServerStart return
+    RSI_STORE_RELEASE(&shard->ready, true);
+    rsi_signal_notify(&server->ready_signal);
+    
+    while (!server->exit_requested) {
+        #ifdef __linux__
+        struct epoll_event events[SERVER_EVENT_BATCH];
+        int ready = epoll_wait(shard->epoll_fd, events, SERVER_EVENT_BATCH, WAKE_TICK_US / 1000);
+        for (int i = 0; i < ready; i++) {
+            service_socket(events[i].data.ptr);
+        }
+        #else
+        #ifdef _WIN32
+        int ready = WSAPoll(shard->fds, (ULONG)shard->member_count, WAKE_TICK_US / 1000);
+        #else
+        int ready = poll(shard->fds, (nfds_t)shard->member_count, WAKE_TICK_US / 1000);
+        #endif
+        for (size_t i = 0; ready > 0 && i < shard->member_count; i++) {
+            if (shard->fds[i].revents) {
+                service_socket(shard->members[i]);
+                ready--;
+            }
+        }
+        #endif
+        
+        // Connection timeouts only need WAKE_TICK_US resolution
+        uint64_t now = get_time_us();
+        if (now >= next_timeout_check) {
+            for (size_t i = 0; i < shard->member_count; i++) {
+                check_connection_timeout(shard->members[i]);
+            }
+            next_timeout_check = now + WAKE_TICK_US;
+        }
+    }
+    
+    if (server->config.verbose) {
+        printf("RSI: Event loop %u exiting\n", shard->index);
+    }
+    
+    return 0;
 }
 
-/* Public API Implementation */
-
-RSI_Error RSI_Init(const RSI_Config* config) {
-    // Check if already initialized
-    if (g_context.initialized) {
-        return RSI_ERROR_ALREADY_RUNNING;
+/**
+ * Release the descriptors and member lists of all shards
+ */
+static void free_shards(RSI_Server* server) {
+    for (uint32_t i = 0; i < server->shard_count; i++) {
+        RSI_Shard* shard = &server->shards[i];
+        #ifdef __linux__
+        if (shard->epoll_fd >= 0) {
+            close(shard->epoll_fd);
+        }
+        #else
+        free(shard->fds);
+        #endif
+        free(shard->members);
     }
     
-    // Clear context
-    memset(&g_context, 0, sizeof(g_context));
+    free(server->shards);
+    server->shards = NULL;
+    server->shard_count = 0;
+}
+
+/**
+ * Deal instances round-robin over the shards and register their sockets
+ */
+static RSI_Error build_shards(RSI_Server* server, uint32_t shard_count) {
+    size_t per_shard = (server->instance_count + shard_count - 1) / shard_count;
     
-    // Initialize stats with default values
-    g_context.stats.min_response_time_ms = 9999.0;
+    server->shards = calloc(shard_count, sizeof(RSI_Shard));
+    if (!server->shards) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    server->shard_count = shard_count;
     
-    // Set configuration (use defaults if NULL)
-    if (config) {
-        memcpy(&g_context.config, config, sizeof(RSI_Config));
-    } else {
-        g_context.config.local_ip = DEFAULT_LOCAL_IP;
-        g_context.config.local_port = DEFAULT_PORT;
-        g_context.config.timeout_ms = DEFAULT_TIMEOUT_MS;
-        g_context.config.verbose = false;
+    #ifdef __linux__
+    for (uint32_t i = 0; i < shard_count; i++) {
+        server->shards[i].epoll_fd = -1;
     }
+    #endif
     
-    // Apply system optimizations
-    init_system_optimizations();
+    for (uint32_t i = 0; i < shard_count; i++) {
+        RSI_Shard* shard = &server->shards[i];
+        shard->server = server;
+        shard->index = i;
+        shard->members = calloc(per_shard, sizeof(RSI_Context*));
+        #ifdef __linux__
+        shard->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (!shard->members || shard->epoll_fd < 0) {
+            return RSI_ERROR_INIT_FAILED;
+        }
+        #else
+        shard->fds = calloc(per_shard, sizeof(*shard->fds));
+        if (!shard->members || !shard->fds) {
+            return RSI_ERROR_INIT_FAILED;
+        }
+        #endif
+    }
     
-    // Initialize network
-    RSI_Error err = init_network();
-    if (err != RSI_SUCCESS) {
-        cleanup_system_optimizations();
-        return err;
+    for (size_t i = 0; i < server->instance_count; i++) {
+        RSI_Context* ctx = server->instances[i];
+        RSI_Shard* shard = &server->shards[i % shard_count];
+        
+        #ifdef __linux__
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = ctx;
+        if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, ctx->sock, &event) < 0) {
+            return RSI_ERROR_SOCKET_FAILED;
+        }
+        #elif defined(_WIN32)
+        shard->fds[shard->member_count].fd = ctx->sock;
+        shard->fds[shard->member_count].events = POLLRDNORM;
+        #else
+        shard->fds[shard->member_count].fd = ctx->sock;
+        shard->fds[shard->member_count].events = POLLIN;
+        #endif
+        shard->members[shard->member_count++] = ctx;
     }
     
-    g_context.initialized = true;
     return RSI_SUCCESS;
 }
 
-RSI_Error RSI_SetCallbacks(RSI_DataCallback data_callback,
-                         RSI_ConnectionCallback connection_callback,
-                         void* user_data) {
-    if (!g_context.initialized) {
-        return RSI_ERROR_INIT_FAILED;
-    }
+/**
+ * Stop the first started_threads event loops and close every socket
+ */
+static void stop_shards(RSI_Server* server, uint32_t started_threads) {
+    server->exit_requested = true;
     
-    if (g_context.running) {
-        return RSI_ERROR_ALREADY_RUNNING;
+    for (uint32_t i = 0; i < started_threads; i++) {
+        #ifdef _WIN32
+        WaitForSingleObject(server->shards[i].thread, 1000);
+        CloseHandle(server->shards[i].thread);
+        #else
+        pthread_join(server->shards[i].thread, NULL);
+        #endif
     }
     
-    g_context.data_callback = data_callback;
-    g_context.connection_callback = connection_callback;
-    g_context.callback_user_data = user_data;
+    free_shards(server);
     
-    return RSI_SUCCESS;
+    for (size_t i = 0; i < server->instance_count; i++) {
+        RSI_Context* ctx = server->instances[i];
+        
+        stop_gap_thread(ctx);
+        close_socket(ctx);
+        
+        // Release RSI_WaitForCycle callers
+        RSI_STORE_RELEASE(&ctx->running, false);
+        rsi_signal_notify(&ctx->cycle_signal);
+    }
 }
 
-RSI_Error RSI_Start(void) {
-    RSI_Error err;
-    
-    // Check if initialized
-    if (!g_context.initialized) {
-        return RSI_ERROR_INIT_FAILED;
+RSI_Error RSI_ServerCreate(const RSI_ServerConfig* config, RSI_ServerHandle* handle) {
+    if (!handle) {
+        return RSI_ERROR_INVALID_PARAM;
     }
+    *handle = NULL;
     
-    // Check if already running
-    if (g_context.running) {
-        return RSI_ERROR_ALREADY_RUNNING;
+    if (config && config->thread_count > SERVER_MAX_THREADS) {
+        return RSI_ERROR_INVALID_PARAM;
     }
     
-    // Create and configure socket
-    const char* local_ip = g_context.config.local_ip ? g_context.config.local_ip : DEFAULT_LOCAL_IP;
-    uint16_t local_port = g_context.config.local_port ? g_context.config.local_port : DEFAULT_PORT;
+    // Threads are pinned through the same 64-bit mask as RSI_Config.cpu_mask
+    for (uint32_t i = 0; config && config->cpus && i < config->thread_count; i++) {
+        if (config->cpus[i] >= 64) {
+            return RSI_ERROR_INVALID_PARAM;
+        }
+    }
     
-    err = create_optimized_socket(local_ip, local_port);
-    if (err != RSI_SUCCESS) {
-        return err;
+    // An event loop has no period of its own to reserve runtime for
+    if (config && config->sched_policy == RSI_SCHED_DEADLINE) {
+        return RSI_ERROR_INVALID_PARAM;
     }
     
-    // Initialize exit flag
-    g_exit_requested = false;
+    RSI_Server* server = calloc(1, sizeof(RSI_Server));
+    if (!server) {
+        return RSI_ERROR_INIT_FAILED;
+    }
+    rsi_signal_init(&server->ready_signal);
     
-    // Start network thread
-    #ifdef _WIN32
-    g_context.network_thread = (HANDLE)_beginthreadex(NULL, 0, network_thread_func, NULL, 0, NULL);
-    if (g_context.network_thread == NULL) {
-        if (g_context.config.verbose) {
-            printf("RSI: Failed to create network thread\n");
-        }
-        CLOSE_SOCKET(g_context.sock);
-        return RSI_ERROR_THREAD_FAILED;
+    if (config) {
+        server->config = *config;
     }
-    #else
-    if (pthread_create(&g_context.network_thread, NULL, network_thread_func, NULL) != 0) {
-        if (g_context.config.verbose) {
-            printf("RSI: Failed to create network thread\n");
-        }
-        CLOSE_SOCKET(g_context.sock);
-        return RSI_ERROR_THREAD_FAILED;
+    if (server->config.thread_count == 0) {
+        server->config.thread_count = 1;
     }
-    #endif
     
-    g_context.running = true;
-    
-    if (g_context.config.verbose) {
-        printf("RSI: Started successfully\n");
+    for (uint32_t i = 0; i < SERVER_MAX_THREADS; i++) {
+        bool configured = server->config.cpus && i < server->config.thread_count;
+        server->cpus[i] = configured ? server->config.cpus[i] : -1;
     }
+    server->config.cpus = NULL;
     
+    *handle = server;
     return RSI_SUCCESS;
 }
 
-RSI_Error RSI_Stop(void) {
-    // Check if initialized and running
-    if (!g_context.initialized) {
-        return RSI_ERROR_INIT_FAILED;
+RSI_Error RSI_ServerAdd(RSI_ServerHandle server, RSI_Handle ctx) {
+    if (!server || !ctx) {
+        return RSI_ERROR_INVALID_PARAM;
     }
     
-    if (!g_context.running) {
-        return RSI_ERROR_NOT_RUNNING;
+    if (!ctx->initialized) {
+        return RSI_ERROR_INIT_FAILED;
     }
     
-    // Signal thread to exit
-    g_exit_requested = true;
-    
-    // Wait for thread to exit
-    #ifdef _WIN32
-    WaitForSingleObject(g_context.network_thread, 1000);
-    CloseHandle(g_context.network_thread);
-    g_context.network_thread = NULL;
-    #else
-    pthread_join(g_context.network_thread, NULL);
-    #endif
-    
-    // Close socket
-    CLOSE_SOCKET(g_context.sock);
+    if (server->running || ctx->running) {
+        return RSI_ERROR_ALREADY_RUNNING;
+    }
     
-    g_context.running = false;
+    if (ctx->server) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
     
-    if (g_context.config.verbose) {
-        printf("RSI: Stopped successfully\n");
+    if (server->instance_count == server->instance_capacity) {
+        size_t capacity = server->instance_capacity ? server->instance_capacity * 2 : 8;
+        RSI_Context** instances = realloc(server->instances, capacity * sizeof(RSI_Context*));
+        if (!instances) {
+            return RSI_ERROR_INIT_FAILED;
+        }
+        server->instances = instances;
+        server->instance_capacity = capacity;
     }
     
+    server->instances[server->instance_count++] = ctx;
+    ctx->server = server;
     return RSI_SUCCESS;
 }
 
-RSI_Error RSI_Cleanup(void) {
-    // Check if initialized
-    if (!g_context.initialized) {
-        return RSI_ERROR_INIT_FAILED;
+RSI_Error RSI_ServerStart(RSI_ServerHandle server) {
+    RSI_Error err;
+    size_t opened;
+    
+    if (!server || server->instance_count == 0) {
+        return RSI_ERROR_INVALID_PARAM;
     }
     
-    // Stop if still running
-    if (g_context.running) {
-        RSI_Error err = RSI_Stop();
+    if (server->running) {
+        return RSI_ERROR_ALREADY_RUNNING;
+    }
+    
+    // Bind every robot first so a taken port leaves nothing running
+    for (opened = 0; opened < server->instance_count; opened++) {
+        err = open_socket(server->instances[opened]);
         if (err != RSI_SUCCESS) {
+            while (opened > 0) {
+                close_socket(server->instances[--opened]);
+            }
             return err;
         }
     }
     
-    // Clean up network
-    #ifdef _WIN32
-    WSACleanup();
-    #endif
-    
-    // Clean up system optimizations
-    cleanup_system_optimizations();
+    uint32_t shard_count = server->config.thread_count;
+    if (shard_count > server->instance_count) {
+        shard_count = (uint32_t)server->instance_count;
+    }
     
-    g_context.initialized = false;
+    err = build_shards(server, shard_count);
+    if (err != RSI_SUCCESS) {
+        if (server->config.verbose) {
+            printf("RSI: Failed to set up event loops\n");
+        }
+        stop_shards(server, 0);
+        return err;
+    }
     
-    if (g_context.config.verbose) {
-        printf("RSI: Cleaned up successfully\n");
+    for (size_t i = 0; i < server->instance_count; i++) {
+        if (!start_gap_thread(server->instances[i])) {
+            if (server->config.verbose) {
+                printf("RSI: Failed to create gap thread\n");
+            }
+            stop_shards(server, 0);
+            return RSI_ERROR_THREAD_FAILED;
+        }
     }
     
-    return RSI_SUCCESS;
-}
-
-RSI_Error RSI_GetCartesianPosition(RSI_CartesianPosition* position) {
-    // Check if initialized and running
-    if (!g_context.initialized) {
-        return RSI_ERROR_INIT_FAILED;
+    server->exit_requested = false;
+    for (size_t i = 0; i < server->instance_count; i++) {
+        server->instances[i]->exit_requested = false;
+        RSI_STORE_RELEASE(&server->instances[i]->running, true);
     }
     
-    if (!g_context.running) {
-        return RSI_ERROR_NOT_RUNNING;
+    for (uint32_t i = 0; i < shard_count; i++) {
+        RSI_StartupDiagnostics* diagnostics = &server->diagnostics[i];
+        diagnostics->memory_lock = setup_result(RSI_ERROR_NOT_ENABLED);
+        diagnostics->affinity = setup_result(RSI_ERROR_NOT_ENABLED);
+        diagnostics->scheduling = setup_result(RSI_ERROR_NOT_ENABLED);
+        diagnostics->stack_prefault = setup_result(RSI_ERROR_NOT_ENABLED);
+        diagnostics->cpu = -1;
     }
     
-    if (!position) {
-        return RSI_ERROR_INVALID_PARAM;
+    for (uint32_t i = 0; i < shard_count; i++) {
+        RSI_Shard* shard = &server->shards[i];
+        #ifdef _WIN32
+        shard->thread = (HANDLE)_beginthreadex(NULL, 0, shard_thread_func, shard, 0, NULL);
+        bool started = shard->thread != NULL;
+        #else
+        bool started = create_thread(&shard->thread, shard_thread_func, shard) == 0;
+        #endif
+        if (!started) {
+            if (server->config.verbose) {
+                printf("RSI: Failed to create event loop thread\n");
+            }
+            stop_shards(server, i);
+            return RSI_ERROR_THREAD_FAILED;
+        }
     }
     
-    // Lock data
-    #ifdef _WIN32
-    EnterCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_lock(&g_context.data_lock);
-    #endif
+    // Wait until every thread has applied its real-time setup
+    for (uint32_t i = 0; i < shard_count; i++) {
+        for (;;) {
+            uint32_t seen = rsi_signal_sequence(&server->ready_signal);
+            if (RSI_LOAD_ACQUIRE(&server->shards[i].ready)) {
+                break;
+            }
+            rsi_signal_wait(&server->ready_signal, seen, WAKE_TICK_US);
+        }
+    }
     
-    // Copy data
-    memcpy(position, &g_context.cartesian, sizeof(RSI_CartesianPosition));
+    server->started_threads = shard_count;
+    server->running = true;
     
-    // Unlock data
-    #ifdef _WIN32
-    LeaveCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_unlock(&g_context.data_lock);
-    #endif
+    if (server->config.verbose) {
+        printf("RSI: Server started, %u robots on %u threads\n",
+               (unsigned)server->instance_count, shard_count);
+    }
     
     return RSI_SUCCESS;
 }
 
-RSI_Error RSI_GetJointPosition(RSI_JointPosition* position) {
-    // Check if initialized and running
-    if (!g_context.initialized) {
-        return RSI_ERROR_INIT_FAILED;
+RSI_Error RSI_ServerGetStartupDiagnostics(RSI_ServerHandle server, uint32_t thread,
+                                          RSI_StartupDiagnostics* diagnostics) {
+    if (!server || !diagnostics) {
+        return RSI_ERROR_INVALID_PARAM;
     }
     
-    if (!g_context.running) {
+    if (server->started_threads == 0) {
         return RSI_ERROR_NOT_RUNNING;
     }
     
-    if (!position) {
+    if (thread >= server->started_threads) {
         return RSI_ERROR_INVALID_PARAM;
     }
     
-    // Lock data
-    #ifdef _WIN32
-    EnterCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_lock(&g_context.data_lock);
-    #endif
-    
-    // Copy data
-    memcpy(position, &g_context.joints, sizeof(RSI_JointPosition));
-    
-    // Unlock data
-    #ifdef _WIN32
-    LeaveCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_unlock(&g_context.data_lock);
-    #endif
-    
+    *diagnostics = server->diagnostics[thread];
     return RSI_SUCCESS;
 }
 
-RSI_Error RSI_SetCartesianCorrection(const RSI_CartesianCorrection* correction) {
-    // Check if initialized and running
-    if (!g_context.initialized) {
-        return RSI_ERROR_INIT_FAILED;
+RSI_Error RSI_ServerStop(RSI_ServerHandle server) {
+    if (!server) {
+        return RSI_ERROR_INVALID_PARAM;
     }
     
-    if (!g_context.running) {
+    if (!server->running) {
         return RSI_ERROR_NOT_RUNNING;
     }
     
-    if (!correction) {
-        return RSI_ERROR_INVALID_PARAM;
-    }
-    
-    // Lock data
-    #ifdef _WIN32
-    EnterCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_lock(&g_context.data_lock);
-    #endif
-    
-    // Copy correction data
-    memcpy(&g_context.correction, correction, sizeof(RSI_CartesianCorrection));
+    stop_shards(server, server->shard_count);
+    server->running = false;
     
-    // Unlock data
-    #ifdef _WIN32
-    LeaveCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_unlock(&g_context.data_lock);
-    #endif
+    if (server->config.verbose) {
+        printf("RSI: Server stopped\n");
+    }
     
     return RSI_SUCCESS;
 }
 
-RSI_Error RSI_GetStatistics(RSI_Statistics* stats) {
-    // Check if initialized
-    if (!g_context.initialized) {
-        return RSI_ERROR_INIT_FAILED;
+RSI_Error RSI_ServerDestroy(RSI_ServerHandle server) {
+    if (!server) {
+        return RSI_ERROR_INVALID_PARAM;
     }
     
-    if (!stats) {
-        return RSI_ERROR_INVALID_PARAM;
+    if (server->running) {
+        RSI_ServerStop(server);
     }
     
-    // Lock data
-    #ifdef _WIN32
-    EnterCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_lock(&g_context.data_lock);
-    #endif
+    // Instances stay valid and can be destroyed or started on their own
+    for (size_t i = 0; i < server->instance_count; i++) {
+        server->instances[i]->server = NULL;
+    }
+    
+    rsi_signal_destroy(&server->ready_signal);
+    free(server->instances);
+    free(server);
+    return RSI_SUCCESS;
+}
+
+/* Benchmark hooks (see internal.h) */
+
+int rsi_process_datagram(RSI_Handle ctx, const char* data, size_t len) {
+    if (!ctx || !ctx->initialized || ctx->running || ctx->server || len > MAX_BUFFER_SIZE - 1) {
+        return -1;
+    }
     
-    // Copy statistics
-    memcpy(stats, &g_context.stats, sizeof(RSI_Statistics));
+    ctx->recv_kernel_us = 0;
+    ctx->recv_stale = 0;
+    ctx->drain_count = 0;
+    ctx->drain_answered = -1;
+    return process_packet(ctx, data, (int)len, NULL);
+}
+
+int rsi_generate_response(RSI_Handle ctx, const char* ipoc, size_t ipoc_len, char* buffer, size_t buffer_size) {
+    RSI_CartesianCorrection sent;
+    RSI_Slice slice = { ipoc, (uint32_t)ipoc_len };
     
-    // Unlock data
-    #ifdef _WIN32
-    LeaveCriticalSection(&g_context.data_lock);
-    #else
-    pthread_mutex_unlock(&g_context.data_lock);
-    #endif
+    if (!ctx || !ctx->initialized || ctx->running || ctx->server) {
+        return -1;
+    }
     
-    return RSI_SUCCESS;
+    return generate_response(ctx, slice, buffer, buffer_size, &sent);
+}
+
+/* Handle-less API, operating on the default instance */
+
+RSI_Error RSI_Init(const RSI_Config* config) {
+    return init_context(&g_context, config);
+}
+
+RSI_Error RSI_SetCallbacks(RSI_DataCallback data_callback,
+                         RSI_ConnectionCallback connection_callback,
+                         void* user_data) {
+    return RSI_SetCallbacksH(&g_context, data_callback, connection_callback, user_data);
+}
+
+RSI_Error RSI_SetGapCallback(RSI_GapCallback gap_callback, void* user_data) {
+    return RSI_SetGapCallbackH(&g_context, gap_callback, user_data);
+}
+
+RSI_Error RSI_Start(void) {
+    return RSI_StartH(&g_context);
+}
+
+RSI_Error RSI_Stop(void) {
+    return RSI_StopH(&g_context);
+}
+
+RSI_Error RSI_Cleanup(void) {
+    return cleanup_context(&g_context);
+}
+
+RSI_Error RSI_GetCartesianPosition(RSI_CartesianPosition* position) {
+    return RSI_GetCartesianPositionH(&g_context, position);
+}
+
+RSI_Error RSI_GetJointPosition(RSI_JointPosition* position) {
+    return RSI_GetJointPositionH(&g_context, position);
+}
+
+RSI_Error RSI_SetCartesianCorrection(const RSI_CartesianCorrection* correction) {
+    return RSI_SetCartesianCorrectionH(&g_context, correction);
+}
+
+RSI_Error RSI_QueueCorrections(const RSI_CartesianCorrection* corrections, size_t count, size_t* queued) {
+    return RSI_QueueCorrectionsH(&g_context, corrections, count, queued);
+}
+
+RSI_Error RSI_FlushCorrections(void) {
+    return RSI_FlushCorrectionsH(&g_context);
+}
+
+RSI_Error RSI_GetStatistics(RSI_Statistics* stats) {
+    return RSI_GetStatisticsH(&g_context, stats);
+}
+
+RSI_Error RSI_GetPercentiles(RSI_Percentiles* percentiles) {
+    return RSI_GetPercentilesH(&g_context, percentiles);
+}
+
+RSI_Error RSI_GetWindowPercentiles(bool reset, RSI_Percentiles* percentiles) {
+    return RSI_GetWindowPercentilesH(&g_context, reset, percentiles);
+}
+
+RSI_Error RSI_GetJitterPercentiles(RSI_Percentiles* percentiles) {
+    return RSI_GetJitterPercentilesH(&g_context, percentiles);
+}
+
+RSI_Error RSI_GetStagePercentiles(RSI_Stage stage, RSI_Percentiles* percentiles) {
+    return RSI_GetStagePercentilesH(&g_context, stage, percentiles);
+}
+
+RSI_Error RSI_GetFrame(RSI_Frame* frame) {
+    return RSI_GetFrameH(&g_context, frame);
+}
+
+RSI_Error RSI_WaitForCycle(uint32_t last_ipoc, uint32_t timeout_ms, RSI_Frame* frame) {
+    return RSI_WaitForCycleH(&g_context, last_ipoc, timeout_ms, frame);
+}
+
+RSI_Error RSI_GetEventFd(int* fd) {
+    return RSI_GetEventFdH(&g_context, fd);
+}
+
+RSI_Error RSI_GetStartupDiagnostics(RSI_StartupDiagnostics* diagnostics) {
+    return RSI_GetStartupDiagnosticsH(&g_context, diagnostics);
+}
+
+RSI_Error RSI_ReadSamples(RSI_Sample* samples, size_t max_samples, size_t* count) {
+    return RSI_ReadSamplesH(&g_context, samples, max_samples, count);
+}
+
+RSI_Error RSI_DumpTrace(const char* path) {
+    return RSI_DumpTraceH(&g_context, path);
 }
 
 const char* RSI_GetErrorString(RSI_Error error) {
@@ -888,6 +3708,12 @@ const char* RSI_GetErrorString(RSI_Error error) {
             return "Invalid parameter provided";
         case RSI_ERROR_TIMEOUT:
             return "Operation timed out";
+        case RSI_ERROR_NOT_ENABLED:
+            return "Feature not enabled in configuration";
+        case RSI_ERROR_NOT_SUPPORTED:
+            return "Not supported on this platform";
+        case RSI_ERROR_FILE_FAILED:
+            return "File could not be written";
         case RSI_ERROR_UNKNOWN:
         default:
             return "Unknown error";
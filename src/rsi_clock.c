@@ -0,0 +1,179 @@
+/**
+ * @file rsi_clock.c
+ * @brief Cheap tick counter for timing the stages of a cycle
+ *
+ * On x86 the time stamp counter is used when the CPU reports it as invariant
+ * (constant rate, running in all sleep states); its rate is calibrated once
+ * against CLOCK_MONOTONIC. AArch64 reads the virtual counter, whose rate is
+ * published in a system register. Windows uses the performance counter and
+ * everything else falls back to CLOCK_MONOTONIC, counting nanoseconds.
+ * Ticks are only meaningful as differences.
+ */
+
+#include "internal.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(_WIN32)
+    #define RSI_CLOCK_TSC 1
+    #include <cpuid.h>
+    #include <x86intrin.h>
+#else
+    #define RSI_CLOCK_TSC 0
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__)
+    #define RSI_CLOCK_CNTVCT 1
+#else
+    #define RSI_CLOCK_CNTVCT 0
+#endif
+
+#define CALIBRATION_NS 10000000   /* TSC calibration interval */
+#define CALIBRATION_TRIES 8       /* Clock reads bracketing each TSC read */
+
+typedef enum {
+    CLOCK_UNSET = 0,
+    CLOCK_TSC,
+    CLOCK_CNTVCT,
+    CLOCK_QPC,
+    CLOCK_MONOTONIC_NS
+} RSI_ClockSource;
+
+static RSI_ClockSource g_clock_source = CLOCK_UNSET;
+static double g_tick_ns = 1.0;
+
+static const char* const CLOCK_NAMES[] = { "unset", "tsc", "cntvct", "qpc", "clock_gettime" };
+
+#ifndef _WIN32
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#if RSI_CLOCK_TSC
+static bool tsc_invariant(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (edx & (1u << 8)) != 0;
+}
+
+/**
+ * Read the TSC together with the monotonic clock; the read with the
+ * tightest bracket wins, so a preemption cannot skew the pair.
+ * The first read is always taken, so both outputs are set.
+ */
+static void tsc_sample(uint64_t* ns, uint64_t* ticks) {
+    uint64_t best = 0;
+
+    for (int i = 0; i < CALIBRATION_TRIES; i++) {
+        uint64_t before = monotonic_ns();
+        uint64_t tsc = __rdtsc();
+        uint64_t after = monotonic_ns();
+
+        if (i == 0 || after - before < best) {
+            best = after - before;
+            *ns = before + (after - before) / 2;
+            *ticks = tsc;
+        }
+    }
+}
+
+static double tsc_calibrate(void) {
+    struct timespec pause = { 0, CALIBRATION_NS };
+    uint64_t start_ns, start_ticks, end_ns, end_ticks;
+
+    tsc_sample(&start_ns, &start_ticks);
+    nanosleep(&pause, NULL);
+    tsc_sample(&end_ns, &end_ticks);
+
+    if (end_ticks <= start_ticks) {
+        return 0.0;
+    }
+    return (double)(end_ns - start_ns) / (double)(end_ticks - start_ticks);
+}
+#endif
+
+void rsi_clock_init(void) {
+    // Published last, so a racing first call only calibrates twice
+    if (RSI_LOAD_ACQUIRE(&g_clock_source) != CLOCK_UNSET) {
+        return;
+    }
+
+    RSI_ClockSource source = CLOCK_MONOTONIC_NS;
+    double tick_ns = 1.0;
+
+    #ifdef _WIN32
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    source = CLOCK_QPC;
+    tick_ns = 1e9 / (double)freq.QuadPart;
+    #elif RSI_CLOCK_TSC
+    if (tsc_invariant()) {
+        double calibrated = tsc_calibrate();
+        if (calibrated > 0.0) {
+            source = CLOCK_TSC;
+            tick_ns = calibrated;
+        }
+    }
+    #elif RSI_CLOCK_CNTVCT
+    uint64_t freq;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    if (freq != 0) {
+        source = CLOCK_CNTVCT;
+        tick_ns = 1e9 / (double)freq;
+    }
+    #endif
+
+    g_tick_ns = tick_ns;
+    RSI_STORE_RELEASE(&g_clock_source, source);
+}
+
+uint64_t rsi_clock_ticks(void) {
+    switch (g_clock_source) {
+        #if RSI_CLOCK_TSC
+        case CLOCK_TSC:
+            return __rdtsc();
+        #endif
+
+        #if RSI_CLOCK_CNTVCT
+        case CLOCK_CNTVCT: {
+            uint64_t ticks;
+            __asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(ticks) :: "memory");
+            return ticks;
+        }
+        #endif
+
+        #ifdef _WIN32
+        case CLOCK_QPC: {
+            LARGE_INTEGER count;
+            QueryPerformanceCounter(&count);
+            return (uint64_t)count.QuadPart;
+        }
+        #else
+        case CLOCK_MONOTONIC_NS:
+            return monotonic_ns();
+        #endif
+
+        default:
+            rsi_clock_init();
+            return rsi_clock_ticks();
+    }
+}
+
+double rsi_clock_tick_ns(void) {
+    rsi_clock_init();
+    return g_tick_ns;
+}
+
+const char* rsi_clock_name(void) {
+    rsi_clock_init();
+    return CLOCK_NAMES[g_clock_source];
+}
@@ -0,0 +1,119 @@
+/**
+ * @file rsi_histogram.c
+ * @brief Fixed-memory log-linear histogram for latency percentiles
+ *
+ * The network thread is the only writer and records each value with one
+ * relaxed increment. Readers copy the counts bucket by bucket while it keeps
+ * running. A copy may miss the values recorded during the copy, but no
+ * count is ever torn. A windowed view is the difference between two copies,
+ * so the writer never resets anything.
+ */
+
+#include "internal.h"
+
+#include <string.h>
+
+#define SUB_COUNT (1u << RSI_HISTOGRAM_SUB_BITS)
+
+/**
+ * Bucket of a value; the identity below 2 * SUB_COUNT
+ */
+static uint32_t bucket_index(uint64_t value) {
+    if (value < 2 * SUB_COUNT) {
+        return (uint32_t)value;
+    }
+
+    uint32_t msb = 63 - (uint32_t)__builtin_clzll(value);
+    if (msb >= RSI_HISTOGRAM_MAX_BITS) {
+        return RSI_HISTOGRAM_BUCKETS - 1;
+    }
+
+    uint32_t shift = msb - RSI_HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << RSI_HISTOGRAM_SUB_BITS) + (uint32_t)(value >> shift) - SUB_COUNT;
+}
+
+/**
+ * Highest value that falls into a bucket
+ */
+static uint64_t bucket_highest(uint32_t index) {
+    uint32_t group = index >> RSI_HISTOGRAM_SUB_BITS;
+    uint64_t sub = index & (SUB_COUNT - 1);
+
+    if (group <= 1) {
+        return index;
+    }
+
+    uint32_t shift = group - 1;
+    return ((SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+/**
+ * Lowest value that falls into a bucket
+ */
+static uint64_t bucket_lowest(uint32_t index) {
+    return index ? bucket_highest(index - 1) + 1 : 0;
+}
+
+void rsi_histogram_record(RSI_Histogram* histogram, uint64_t value) {
+    uint64_t* count = &histogram->counts[bucket_index(value)];
+    RSI_STORE_RELAXED(count, RSI_LOAD_RELAXED(count) + 1);
+}
+
+void rsi_histogram_snapshot(const RSI_Histogram* histogram, RSI_Histogram* out) {
+    for (uint32_t i = 0; i < RSI_HISTOGRAM_BUCKETS; i++) {
+        out->counts[i] = RSI_LOAD_RELAXED(&histogram->counts[i]);
+    }
+}
+
+/**
+ * Count of a bucket, minus the count of an earlier snapshot if given
+ */
+static uint64_t bucket_count(const RSI_Histogram* histogram, const RSI_Histogram* earlier, uint32_t index) {
+    return histogram->counts[index] - (earlier ? earlier->counts[index] : 0);
+}
+
+void rsi_histogram_percentiles(const RSI_Histogram* histogram, const RSI_Histogram* earlier,
+                               double scale, RSI_Percentiles* out) {
+    static const double RANKS[] = { 50.0, 90.0, 99.0, 99.9, 99.99 };
+    double* results[] = { &out->p50_ms, &out->p90_ms, &out->p99_ms, &out->p999_ms, &out->p9999_ms };
+    uint64_t total = 0;
+    uint32_t first = RSI_HISTOGRAM_BUCKETS;
+    uint32_t last = 0;
+
+    for (uint32_t i = 0; i < RSI_HISTOGRAM_BUCKETS; i++) {
+        uint64_t count = bucket_count(histogram, earlier, i);
+        if (count) {
+            total += count;
+            if (first == RSI_HISTOGRAM_BUCKETS) {
+                first = i;
+            }
+            last = i;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->count = total;
+    if (total == 0) {
+        return;
+    }
+
+    out->min_ms = (double)bucket_lowest(first) * scale;
+    out->max_ms = (double)bucket_highest(last) * scale;
+
+    // Smallest bucket whose cumulative count reaches each rank; reported as
+    // the highest value of that bucket, so percentiles never understate
+    uint64_t cumulative = 0;
+    uint32_t bucket = first;
+    for (size_t r = 0; r < sizeof(RANKS) / sizeof(RANKS[0]); r++) {
+        uint64_t target = (uint64_t)(RANKS[r] / 100.0 * (double)total + 0.999999);
+        if (target == 0) {
+            target = 1;
+        }
+
+        while (cumulative + bucket_count(histogram, earlier, bucket) < target) {
+            cumulative += bucket_count(histogram, earlier, bucket);
+            bucket++;
+        }
+        *results[r] = (double)bucket_highest(bucket) * scale;
+    }
+}
@@ -0,0 +1,206 @@
+/**
+ * @file rsi_number.c
+ * @brief Locale-independent numeric codec for RSI packets
+ *
+ * KUKA controllers send short fixed-point decimals such as "-123.4567".
+ * These are converted exactly with a single integer accumulation and one
+ * division by a power of ten; anything else (long mantissas, exponents,
+ * special values) takes a slower path through strtod that is made
+ * independent of LC_NUMERIC. Output uses the same '.' radix regardless of
+ * the process locale.
+ */
+
+#include "internal.h"
+
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Longest numeric string accepted by the slow path */
+#define NUMBER_MAX_LENGTH 64
+
+/* Exactly representable powers of ten */
+static const double POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Values up to this magnitude keep all four decimals exact in the fast path */
+#define FIXED4_FAST_LIMIT 4.5e11
+
+static bool is_digit(char c) {
+    return (unsigned)(c - '0') < 10;
+}
+
+/**
+ * Radix character of the current C locale if it differs from '.'
+ */
+static char locale_radix(void) {
+    const char* radix = localeconv()->decimal_point;
+    if (radix && radix[0] != '\0' && radix[0] != '.' && radix[1] == '\0') {
+        return radix[0];
+    }
+    return '.';
+}
+
+/**
+ * Correct conversion of anything the fast path does not handle
+ */
+static bool parse_double_slow(const char* str, size_t len, double* value) {
+    char buffer[NUMBER_MAX_LENGTH + 1];
+    char* endptr;
+    char radix;
+
+    if (len == 0 || len > NUMBER_MAX_LENGTH) return false;
+
+    memcpy(buffer, str, len);
+    buffer[len] = '\0';
+
+    // strtod follows LC_NUMERIC, so hand it the radix it expects
+    radix = locale_radix();
+    if (radix != '.') {
+        char* dot = memchr(buffer, '.', len);
+        if (dot) *dot = radix;
+    }
+
+    double result = strtod(buffer, &endptr);
+    if (endptr != buffer + len) return false;
+
+    *value = result;
+    return true;
+}
+
+bool rsi_parse_double(const char* str, size_t len, double* value) {
+    const char* p = str;
+    const char* end = str + len;
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int frac_digits = 0;
+    bool negative = false;
+    bool any_digits = false;
+
+    #if FLT_EVAL_METHOD != 0
+    // Extended intermediate precision would double-round the division
+    return parse_double_slow(str, len, value);
+    #endif
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    for (; p < end && is_digit(*p); p++) {
+        if ((mantissa || *p != '0') && ++significant > 19) goto slow;
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        any_digits = true;
+    }
+
+    if (p < end && *p == '.') {
+        for (p++; p < end && is_digit(*p); p++) {
+            if ((mantissa || *p != '0') && ++significant > 19) goto slow;
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            frac_digits++;
+            any_digits = true;
+        }
+    }
+
+    // Exponents and anything unusual are validated by the slow path
+    if (!any_digits || p != end) goto slow;
+
+    // Both operands exact, so the single IEEE division rounds correctly
+    if (mantissa > (1ULL << 53) || frac_digits > 22) goto slow;
+
+    double result = (double)mantissa;
+    if (frac_digits) {
+        result /= POW10[frac_digits];
+    }
+
+    *value = negative ? -result : result;
+    return true;
+
+slow:
+    return parse_double_slow(str, len, value);
+}
+
+bool rsi_parse_uint32(const char* str, size_t len, uint32_t* value) {
+    uint64_t result = 0;
+
+    if (len == 0 || len > 10) return false;
+
+    for (size_t i = 0; i < len; i++) {
+        if (!is_digit(str[i])) return false;
+        result = result * 10 + (uint64_t)(str[i] - '0');
+    }
+
+    if (result > UINT32_MAX) return false;
+
+    *value = (uint32_t)result;
+    return true;
+}
+
+/**
+ * printf("%.4f") fallback for huge and non-finite values
+ */
+static int format_fixed4_slow(double value, char* buffer, size_t buffer_size) {
+    int written = snprintf(buffer, buffer_size, "%.4f", value);
+    if (written < 0 || written >= (int)buffer_size) {
+        return 0;
+    }
+
+    char radix = locale_radix();
+    if (radix != '.') {
+        char* sep = memchr(buffer, radix, (size_t)written);
+        if (sep) *sep = '.';
+    }
+
+    return written;
+}
+
+int rsi_format_fixed4(double value, char* buffer, size_t buffer_size) {
+    char digits[24];
+    int count = 0;
+    int len = 0;
+
+    if (!(fabs(value) < FIXED4_FAST_LIMIT)) {
+        return format_fixed4_slow(value, buffer, buffer_size);
+    }
+
+    // Exact product value * 10^4 as scaled + residual
+    double magnitude = fabs(value);
+    double scaled = magnitude * 1e4;
+    double residual = fma(magnitude, 1e4, -scaled);
+    double whole = floor(scaled);
+    double above_half = (scaled - whole - 0.5) + residual;
+
+    // Round half to even on the exact value, like printf
+    uint64_t units = (uint64_t)whole;
+    if (above_half > 0.0 || (above_half == 0.0 && (units & 1))) {
+        units++;
+    }
+
+    // Fractional digits first, then the integer part, all reversed
+    for (int i = 0; i < 4; i++) {
+        digits[count++] = (char)('0' + units % 10);
+        units /= 10;
+    }
+    digits[count++] = '.';
+    do {
+        digits[count++] = (char)('0' + units % 10);
+        units /= 10;
+    } while (units);
+
+    if ((size_t)count + 2 > buffer_size) return 0;
+
+    if (signbit(value)) {
+        buffer[len++] = '-';
+    }
+    while (count) {
+        buffer[len++] = digits[--count];
+    }
+    buffer[len] = '\0';
+
+    return len;
+}
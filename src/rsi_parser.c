@@ -0,0 +1,189 @@
+/**
+ * @file rsi_parser.c
+ * @brief Single-pass, zero-copy tokenizer for incoming RSI packets
+ *
+ * The tokenizer sweeps the datagram once for its structural characters
+ * (see rsi_scan.c) and then walks only those offsets, recording every
+ * element, attribute and text node as a pointer/length pair into the
+ * receive buffer. Nothing is copied and nothing is allocated, so the cost
+ * scales with the packet length only.
+ */
+
+#include "internal.h"
+
+#include <string.h>
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool slice_equals(RSI_Slice slice, const char* str) {
+    size_t len = strlen(str);
+    return slice.len == len && memcmp(slice.ptr, str, len) == 0;
+}
+
+/**
+ * Build a slice with leading and trailing whitespace removed
+ */
+static RSI_Slice make_trimmed_slice(const char* start, const char* end) {
+    RSI_Slice slice;
+
+    while (start < end && is_space(*start)) start++;
+    while (end > start && is_space(end[-1])) end--;
+
+    slice.ptr = start;
+    slice.len = (uint32_t)(end - start);
+    return slice;
+}
+
+/**
+ * Remember the first occurrence of the elements the library consumes
+ */
+static void resolve_well_known(RSI_Packet* packet, const RSI_Element* element) {
+    if (!packet->ipoc && slice_equals(element->name, "IPOC")) {
+        packet->ipoc = element;
+    } else if (!packet->rist && slice_equals(element->name, "RIst")) {
+        packet->rist = element;
+    } else if (!packet->aipos && slice_equals(element->name, "AIPos")) {
+        packet->aipos = element;
+    }
+}
+
+/**
+ * Offset of the next structural character of the given kind (n if none)
+ */
+static size_t next_structural(const char* data, const uint16_t* structural,
+                              size_t i, size_t n, char kind) {
+    while (i < n && data[structural[i]] != kind) i++;
+    return i;
+}
+
+bool rsi_tokenize_packet(const char* data, size_t len, RSI_Packet* packet) {
+    const uint16_t* structural = packet->structural;
+    RSI_Element* open_element = NULL;  /* Element whose character data follows */
+    size_t text_start = 0;
+    size_t i = 0;
+    size_t n;
+
+    packet->element_count = 0;
+    packet->attribute_count = 0;
+    packet->truncated = false;
+    packet->ipoc = NULL;
+    packet->rist = NULL;
+    packet->aipos = NULL;
+
+    if (len > RSI_MAX_PACKET_SIZE) return false;
+
+    n = rsi_scan_structural(data, len, packet->structural);
+
+    while (i < n) {
+        // '=', '"' and '>' are plain character data outside of a tag
+        size_t at = structural[i++];
+        if (data[at] != '<') continue;
+
+        if (open_element) {
+            open_element->text = make_trimmed_slice(data + text_start, data + at);
+            open_element = NULL;
+        }
+
+        size_t p = at + 1;
+        if (p >= len) return false;
+
+        // Closing tag, declaration or comment: skip to '>'
+        if (data[p] == '/' || data[p] == '?' || data[p] == '!') {
+            i = next_structural(data, structural, i, n, '>');
+            if (i >= n) return false;
+            i++;
+            continue;
+        }
+
+        // Element name, which ends before the next structural character
+        size_t limit = i < n ? structural[i] : len;
+        size_t name_start = p;
+        while (p < limit && !is_space(data[p]) && data[p] != '/') p++;
+        if (p == name_start) return false;
+
+        RSI_Element* element = NULL;
+        if (packet->element_count < RSI_MAX_ELEMENTS) {
+            element = &packet->elements[packet->element_count++];
+            element->name.ptr = data + name_start;
+            element->name.len = (uint32_t)(p - name_start);
+            element->text.ptr = data + p;
+            element->text.len = 0;
+            element->first_attribute = packet->attribute_count;
+            element->attribute_count = 0;
+        } else {
+            packet->truncated = true;
+        }
+
+        // Attributes up to '>' or '/>'
+        size_t cursor = p;
+        for (;;) {
+            if (i >= n) return false;
+            at = structural[i++];
+
+            if (data[at] == '>') {
+                if (data[at - 1] != '/' || at - 1 < cursor) {
+                    open_element = element;
+                    text_start = at + 1;
+                }
+                break;
+            }
+
+            // Attribute name runs from the previous token to '='
+            if (data[at] != '=') return false;
+            RSI_Slice name = make_trimmed_slice(data + cursor, data + at);
+            if (name.len == 0) return false;
+
+            // The value must open right after '=' and runs to the next '"'
+            if (i >= n || structural[i] != at + 1 || data[at + 1] != '"') return false;
+            size_t value_start = at + 2;
+            i = next_structural(data, structural, i + 1, n, '"');
+            if (i >= n) return false;
+            size_t value_end = structural[i++];
+
+            if (element && packet->attribute_count < RSI_MAX_ATTRIBUTES) {
+                RSI_Attribute* attr = &packet->attributes[packet->attribute_count++];
+                attr->name = name;
+                attr->value.ptr = data + value_start;
+                attr->value.len = (uint32_t)(value_end - value_start);
+                element->attribute_count++;
+            } else {
+                packet->truncated = true;
+            }
+            cursor = value_end + 1;
+        }
+
+        if (element) {
+            resolve_well_known(packet, element);
+        }
+    }
+
+    // Character data after the last tag
+    if (open_element) {
+        open_element->text = make_trimmed_slice(data + text_start, data + len);
+    }
+
+    return true;
+}
+
+const RSI_Element* rsi_find_element(const RSI_Packet* packet, const char* name) {
+    for (uint16_t i = 0; i < packet->element_count; i++) {
+        if (slice_equals(packet->elements[i].name, name)) {
+            return &packet->elements[i];
+        }
+    }
+    return NULL;
+}
+
+const RSI_Attribute* rsi_find_attribute(const RSI_Packet* packet,
+                                        const RSI_Element* element,
+                                        const char* name) {
+    const RSI_Attribute* attr = &packet->attributes[element->first_attribute];
+    for (uint16_t i = 0; i < element->attribute_count; i++, attr++) {
+        if (slice_equals(attr->name, name)) {
+            return attr;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file rsi_ring.c
+ * @brief Lock-free single-producer/single-consumer ring of fixed-size slots
+ *
+ * Each side owns one index on its own cache line and keeps a cached copy of
+ * the other side's index, so the shared lines are only touched when the
+ * cached view says the ring looks full (producer) or empty (consumer).
+ */
+
+#include "internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <malloc.h>
+#endif
+
+#define RING_ALIGNMENT 64
+
+void* rsi_aligned_zalloc(size_t size) {
+    void* ptr;
+
+    #ifdef _WIN32
+    ptr = _aligned_malloc(size, RING_ALIGNMENT);
+    #else
+    if (posix_memalign(&ptr, RING_ALIGNMENT, size) != 0) {
+        ptr = NULL;
+    }
+    #endif
+
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void rsi_aligned_free(void* ptr) {
+    #ifdef _WIN32
+    _aligned_free(ptr);
+    #else
+    free(ptr);
+    #endif
+}
+
+bool rsi_ring_init(RSI_Ring* ring, size_t capacity, size_t slot_size) {
+    size_t rounded = 1;
+
+    memset(ring, 0, sizeof(*ring));
+    if (capacity == 0 || slot_size == 0) {
+        return false;
+    }
+
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    ring->slots = rsi_aligned_zalloc(rounded * slot_size);
+    if (!ring->slots) {
+        return false;
+    }
+
+    ring->mask = rounded - 1;
+    ring->slot_size = slot_size;
+    return true;
+}
+
+void rsi_ring_free(RSI_Ring* ring) {
+    if (ring->slots) {
+        rsi_aligned_free(ring->slots);
+    }
+    memset(ring, 0, sizeof(*ring));
+}
+
+void* rsi_ring_begin_write(RSI_Ring* ring) {
+    uint64_t head = ring->producer.head;
+
+    if (head - ring->producer.cached_tail > ring->mask) {
+        ring->producer.cached_tail = RSI_LOAD_ACQUIRE(&ring->consumer.tail);
+        if (head - ring->producer.cached_tail > ring->mask) {
+            return NULL;
+        }
+    }
+
+    return ring->slots + (head & ring->mask) * ring->slot_size;
+}
+
+void rsi_ring_end_write(RSI_Ring* ring) {
+    RSI_STORE_RELEASE(&ring->producer.head, ring->producer.head + 1);
+}
+
+const void* rsi_ring_begin_read(RSI_Ring* ring) {
+    uint64_t tail = ring->consumer.tail;
+
+    if (tail == ring->consumer.cached_head) {
+        ring->consumer.cached_head = RSI_LOAD_ACQUIRE(&ring->producer.head);
+        if (tail == ring->consumer.cached_head) {
+            return NULL;
+        }
+    }
+
+    return ring->slots + (tail & ring->mask) * ring->slot_size;
+}
+
+void rsi_ring_end_read(RSI_Ring* ring) {
+    RSI_STORE_RELEASE(&ring->consumer.tail, ring->consumer.tail + 1);
+}
+
+size_t rsi_ring_read(RSI_Ring* ring, void* out, size_t max_count) {
+    uint64_t tail = ring->consumer.tail;
+    uint64_t head = RSI_LOAD_ACQUIRE(&ring->producer.head);
+    size_t count = (size_t)(head - tail);
+    unsigned char* dst = out;
+
+    if (count > max_count) {
+        count = max_count;
+    }
+
+    // Copy in at most two contiguous runs
+    for (size_t copied = 0; copied < count; ) {
+        size_t index = (size_t)((tail + copied) & ring->mask);
+        size_t run = ring->mask + 1 - index;
+        if (run > count - copied) {
+            run = count - copied;
+        }
+
+        memcpy(dst + copied * ring->slot_size, ring->slots + index * ring->slot_size, run * ring->slot_size);
+        copied += run;
+    }
+
+    ring->consumer.cached_head = head;
+    RSI_STORE_RELEASE(&ring->consumer.tail, tail + count);
+    return count;
+}
+
+uint64_t rsi_ring_write_position(const RSI_Ring* ring) {
+    return ring->producer.head;
+}
+
+void rsi_ring_discard(RSI_Ring* ring, uint64_t until) {
+    if (ring->consumer.tail < until) {
+        ring->consumer.cached_head = RSI_LOAD_ACQUIRE(&ring->producer.head);
+        RSI_STORE_RELEASE(&ring->consumer.tail, until);
+    }
+}
+
+size_t rsi_ring_count(const RSI_Ring* ring) {
+    uint64_t tail = RSI_LOAD_ACQUIRE(&ring->consumer.tail);
+    uint64_t head = RSI_LOAD_ACQUIRE(&ring->producer.head);
+    return (size_t)(head - tail);
+}
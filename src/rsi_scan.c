@@ -0,0 +1,150 @@
+/**
+ * @file rsi_scan.c
+ * @brief Structural character scanner for the RSI tokenizer
+ *
+ * Finds the positions of all '<', '=', '"' and '>' characters in a datagram
+ * in one sweep. On x86 the sweep is vectorized (SSE2, or AVX2 when the CPU
+ * supports it); the implementation is selected at runtime and falls back to
+ * a scalar loop everywhere else.
+ */
+
+#include "internal.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define RSI_SCAN_X86 1
+    #include <immintrin.h>
+#else
+    #define RSI_SCAN_X86 0
+#endif
+
+/**
+ * Scalar scan of data[start, len), appending absolute offsets after count
+ */
+static size_t scan_range_scalar(const char* data, size_t start, size_t len,
+                                uint16_t* positions, size_t count) {
+    // Branch-free: always store, only advance on a structural character
+    for (size_t i = start; i < len; i++) {
+        char c = data[i];
+        positions[count] = (uint16_t)i;
+        count += (c == '<') | (c == '=') | (c == '"') | (c == '>');
+    }
+
+    return count;
+}
+
+static size_t scan_structural_scalar(const char* data, size_t len, uint16_t* positions) {
+    return scan_range_scalar(data, 0, len, positions, 0);
+}
+
+#if RSI_SCAN_X86
+
+/**
+ * Append the set bits of a match mask as buffer offsets
+ */
+static inline size_t emit_positions(uint32_t mask, size_t base, uint16_t* positions, size_t count) {
+    while (mask) {
+        positions[count++] = (uint16_t)(base + (size_t)__builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+__attribute__((target("sse2")))
+static size_t scan_structural_sse2(const char* data, size_t len, uint16_t* positions) {
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i eq = _mm_set1_epi8('=');
+    const __m128i qt = _mm_set1_epi8('"');
+    const __m128i gt = _mm_set1_epi8('>');
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, eq)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, qt), _mm_cmpeq_epi8(v, gt)));
+        count = emit_positions((uint32_t)_mm_movemask_epi8(m), i, positions, count);
+    }
+
+    return scan_range_scalar(data, i, len, positions, count);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_structural_avx2(const char* data, size_t len, uint16_t* positions) {
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i eq = _mm256_set1_epi8('=');
+    const __m256i qt = _mm256_set1_epi8('"');
+    const __m256i gt = _mm256_set1_epi8('>');
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, lt), _mm256_cmpeq_epi8(v, eq)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(v, qt), _mm256_cmpeq_epi8(v, gt)));
+        count = emit_positions((uint32_t)_mm256_movemask_epi8(m), i, positions, count);
+    }
+
+    return scan_range_scalar(data, i, len, positions, count);
+}
+
+#endif
+
+/* Implementations in order of preference, filtered by CPU support at init */
+static RSI_ScanImplementation g_scan_available[3];
+static size_t g_scan_available_count = 0;
+static const RSI_ScanImplementation* g_scan_active = NULL;
+
+static void scan_init(void) {
+    size_t count = 0;
+
+    #if RSI_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        g_scan_available[count].name = "avx2";
+        g_scan_available[count].scan = scan_structural_avx2;
+        count++;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        g_scan_available[count].name = "sse2";
+        g_scan_available[count].scan = scan_structural_sse2;
+        count++;
+    }
+    #endif
+
+    g_scan_available[count].name = "scalar";
+    g_scan_available[count].scan = scan_structural_scalar;
+    count++;
+
+    g_scan_available_count = count;
+    g_scan_active = &g_scan_available[0];
+}
+
+size_t rsi_scan_structural(const char* data, size_t len, uint16_t* positions) {
+    // Selection is idempotent, so a racing first call is harmless
+    if (!g_scan_active) {
+        scan_init();
+    }
+    return g_scan_active->scan(data, len, positions);
+}
+
+const RSI_ScanImplementation* rsi_scan_available(size_t* count) {
+    if (!g_scan_active) {
+        scan_init();
+    }
+    *count = g_scan_available_count;
+    return g_scan_available;
+}
+
+const RSI_ScanImplementation* rsi_scan_active(void) {
+    if (!g_scan_active) {
+        scan_init();
+    }
+    return g_scan_active;
+}
+
+void rsi_scan_use(const RSI_ScanImplementation* implementation) {
+    if (!g_scan_active) {
+        scan_init();
+    }
+    g_scan_active = implementation;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file rsi_signal.c
+ * @brief Cycle signal that lets application threads sleep until a packet
+ *
+ * The network thread bumps a sequence number once per cycle. Waiters block
+ * on that word with a futex on Linux, WaitOnAddress on Windows and a
+ * condition variable elsewhere. The waiter count keeps notify down to one
+ * atomic increment and one load when nobody is waiting, so signalling costs
+ * the network thread no system call in the common case.
+ */
+
+#include "internal.h"
+
+#include <limits.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+    #include <unistd.h>
+#else
+    #include <sys/time.h>
+    #include <time.h>
+#endif
+
+void rsi_signal_init(RSI_Signal* signal) {
+    signal->sequence = 0;
+    signal->waiters = 0;
+
+    #if !defined(_WIN32) && !defined(__linux__)
+    pthread_mutex_init(&signal->mutex, NULL);
+    pthread_cond_init(&signal->cond, NULL);
+    #endif
+}
+
+void rsi_signal_destroy(RSI_Signal* signal) {
+    #if !defined(_WIN32) && !defined(__linux__)
+    pthread_mutex_destroy(&signal->mutex);
+    pthread_cond_destroy(&signal->cond);
+    #else
+    (void)signal;
+    #endif
+}
+
+uint32_t rsi_signal_sequence(const RSI_Signal* signal) {
+    return RSI_LOAD_ACQUIRE(&signal->sequence);
+}
+
+void rsi_signal_notify(RSI_Signal* signal) {
+    // Sequentially consistent on both sides: either the waiter sees the new
+    // sequence, or we see its registration and wake it
+    __atomic_add_fetch(&signal->sequence, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&signal->waiters, __ATOMIC_SEQ_CST) == 0) {
+        return;
+    }
+
+    #ifdef _WIN32
+    WakeByAddressAll(&signal->sequence);
+    #elif defined(__linux__)
+    syscall(SYS_futex, &signal->sequence, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+    #else
+    pthread_mutex_lock(&signal->mutex);
+    pthread_cond_broadcast(&signal->cond);
+    pthread_mutex_unlock(&signal->mutex);
+    #endif
+}
+
+bool rsi_signal_wait(RSI_Signal* signal, uint32_t seen, uint64_t timeout_us) {
+    #if defined(_WIN32) || defined(__linux__)
+    __atomic_add_fetch(&signal->waiters, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&signal->sequence, __ATOMIC_SEQ_CST) == seen) {
+        #ifdef _WIN32
+        DWORD timeout_ms = (DWORD)((timeout_us + 999) / 1000);
+        WaitOnAddress(&signal->sequence, &seen, sizeof(seen), timeout_ms);
+        #else
+        struct timespec timeout;
+        timeout.tv_sec = (time_t)(timeout_us / 1000000);
+        timeout.tv_nsec = (long)(timeout_us % 1000000) * 1000;
+        syscall(SYS_futex, &signal->sequence, FUTEX_WAIT_PRIVATE, seen, &timeout, NULL, 0);
+        #endif
+    }
+
+    __atomic_sub_fetch(&signal->waiters, 1, __ATOMIC_SEQ_CST);
+    #else
+    struct timeval now;
+    struct timespec deadline;
+
+    gettimeofday(&now, NULL);
+    uint64_t deadline_us = (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_usec + timeout_us;
+    deadline.tv_sec = (time_t)(deadline_us / 1000000);
+    deadline.tv_nsec = (long)(deadline_us % 1000000) * 1000;
+
+    pthread_mutex_lock(&signal->mutex);
+    __atomic_add_fetch(&signal->waiters, 1, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&signal->sequence, __ATOMIC_SEQ_CST) == seen) {
+        if (pthread_cond_timedwait(&signal->cond, &signal->mutex, &deadline) != 0) {
+            break;
+        }
+    }
+
+    __atomic_sub_fetch(&signal->waiters, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&signal->mutex);
+    #endif
+
+    // Spurious wakeups are possible; callers re-check their condition
+    return RSI_LOAD_ACQUIRE(&signal->sequence) != seen;
+}
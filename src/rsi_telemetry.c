@@ -0,0 +1,358 @@
+/**
+ * @file rsi_telemetry.c
+ * @brief Shared-memory telemetry segment for monitors in other processes
+ *
+ * The owning instance maps a named segment (shm_open on POSIX, a named
+ * file mapping on Windows) and publishes its latest frame there under a
+ * sequence lock, next to copies of its latency histograms. Readers map the
+ * segment read-only and never write to it, so any number of them can
+ * attach without the network thread noticing. The header carries a magic
+ * number and layout version; the magic is cleared when the owner closes
+ * the segment, so attached readers notice.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include "internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#define TELEMETRY_READ_TRIES 10000  /* Seqlock retries before a writer that died mid-update is assumed */
+
+static struct RSI_Telemetry* telemetry_alloc(const char* name) {
+    struct RSI_Telemetry* telemetry;
+
+    if (strlen(name) >= sizeof(telemetry->name)) {
+        return NULL;
+    }
+
+    telemetry = calloc(1, sizeof(*telemetry));
+    if (telemetry) {
+        strcpy(telemetry->name, name);
+    }
+    return telemetry;
+}
+
+static void telemetry_unmap(struct RSI_Telemetry* telemetry) {
+    #ifdef _WIN32
+    UnmapViewOfFile(telemetry->segment);
+    CloseHandle(telemetry->mapping);
+    #else
+    munmap(telemetry->segment, sizeof(RSI_TelemetrySegment));
+    #endif
+}
+
+#ifndef _WIN32
+/**
+ * Map an existing segment read-only
+ *
+ * @return 0 on success, errno otherwise
+ */
+static int map_readonly(const char* name, RSI_TelemetrySegment** segment) {
+    struct stat info;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return errno;
+    }
+
+    // A segment of another layout version may be smaller
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(RSI_TelemetrySegment)) {
+        close(fd);
+        return EPROTO;
+    }
+
+    void* mapped = mmap(NULL, sizeof(RSI_TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+
+    if (mapped == MAP_FAILED) {
+        return error;
+    }
+    *segment = mapped;
+    return 0;
+}
+
+/**
+ * Whether an existing segment still belongs to a live process
+ */
+static bool segment_in_use(const char* name) {
+    RSI_TelemetrySegment* segment;
+    bool in_use = false;
+
+    if (map_readonly(name, &segment) != 0) {
+        return false;
+    }
+
+    if (RSI_LOAD_ACQUIRE(&segment->magic) == RSI_TELEMETRY_MAGIC) {
+        pid_t owner = (pid_t)segment->owner_pid;
+        in_use = kill(owner, 0) == 0 || errno == EPERM;
+    }
+
+    munmap(segment, sizeof(RSI_TelemetrySegment));
+    return in_use;
+}
+#endif
+
+struct RSI_Telemetry* rsi_telemetry_create(const char* name, bool stage_timing, double tick_ns,
+                                           int* os_error) {
+    struct RSI_Telemetry* telemetry = telemetry_alloc(name);
+    RSI_TelemetrySegment* segment;
+
+    *os_error = 0;
+    if (!telemetry) {
+        return NULL;
+    }
+
+    #ifdef _WIN32
+    uint64_t size = sizeof(RSI_TelemetrySegment);
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        (DWORD)(size >> 32), (DWORD)size, name);
+    if (mapping == NULL || GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Named mappings vanish with their last handle, so this one is live
+        *os_error = mapping ? ERROR_ALREADY_EXISTS : (int)GetLastError();
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        free(telemetry);
+        return NULL;
+    }
+
+    segment = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, sizeof(RSI_TelemetrySegment));
+    if (!segment) {
+        *os_error = (int)GetLastError();
+        CloseHandle(mapping);
+        free(telemetry);
+        return NULL;
+    }
+    telemetry->mapping = mapping;
+    #else
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+
+    // Take over a segment left behind by a process that died
+    if (fd < 0 && errno == EEXIST && !segment_in_use(name)) {
+        shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+
+    if (fd < 0) {
+        *os_error = errno;
+        free(telemetry);
+        return NULL;
+    }
+
+    if (ftruncate(fd, sizeof(RSI_TelemetrySegment)) != 0) {
+        *os_error = errno;
+        close(fd);
+        shm_unlink(name);
+        free(telemetry);
+        return NULL;
+    }
+
+    segment = mmap(NULL, sizeof(RSI_TelemetrySegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (segment == MAP_FAILED) {
+        *os_error = errno;
+        close(fd);
+        shm_unlink(name);
+        free(telemetry);
+        return NULL;
+    }
+    close(fd);
+    #endif
+
+    // Touch every page now, so the network thread never faults one in
+    memset(segment, 0, sizeof(RSI_TelemetrySegment));
+
+    segment->version = RSI_TELEMETRY_VERSION;
+    segment->size = sizeof(RSI_TelemetrySegment);
+    #ifdef _WIN32
+    segment->owner_pid = GetCurrentProcessId();
+    #else
+    segment->owner_pid = (uint64_t)getpid();
+    #endif
+    segment->tick_ns = tick_ns;
+    segment->stage_timing = stage_timing;
+    RSI_STORE_RELEASE(&segment->magic, RSI_TELEMETRY_MAGIC);
+
+    telemetry->segment = segment;
+    telemetry->writer = true;
+    return telemetry;
+}
+
+void rsi_telemetry_destroy(struct RSI_Telemetry* telemetry) {
+    if (!telemetry) {
+        return;
+    }
+
+    if (telemetry->writer) {
+        RSI_STORE_RELEASE(&telemetry->segment->magic, 0);
+    }
+    telemetry_unmap(telemetry);
+
+    #ifndef _WIN32
+    if (telemetry->writer) {
+        shm_unlink(telemetry->name);
+    }
+    #endif
+
+    free(telemetry);
+}
+
+void rsi_telemetry_publish(struct RSI_Telemetry* telemetry, const RSI_Frame* frame,
+                           uint64_t response_time_sum_ns) {
+    RSI_TelemetrySegment* segment = telemetry->segment;
+    uint32_t sequence = segment->sequence;
+
+    RSI_STORE_RELAXED(&segment->sequence, sequence + 1);
+    RSI_FENCE_RELEASE();
+
+    segment->frame = *frame;
+    segment->response_time_sum_ns = response_time_sum_ns;
+
+    RSI_STORE_RELEASE(&segment->sequence, sequence + 2);
+}
+
+/* Reader API */
+
+RSI_Error RSI_TelemetryOpen(const char* name, RSI_TelemetryHandle* handle) {
+    if (!name || !handle) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+    *handle = NULL;
+
+    struct RSI_Telemetry* telemetry = telemetry_alloc(name);
+    RSI_TelemetrySegment* segment;
+    if (!telemetry) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+
+    #ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (!mapping) {
+        free(telemetry);
+        return RSI_ERROR_NOT_RUNNING;
+    }
+
+    segment = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(RSI_TelemetrySegment));
+    if (!segment) {
+        CloseHandle(mapping);
+        free(telemetry);
+        return RSI_ERROR_NOT_SUPPORTED;
+    }
+    telemetry->mapping = mapping;
+    #else
+    int error = map_readonly(name, &segment);
+    if (error != 0) {
+        free(telemetry);
+        if (error == ENOENT) {
+            return RSI_ERROR_NOT_RUNNING;
+        }
+        return error == EPROTO ? RSI_ERROR_NOT_SUPPORTED : RSI_ERROR_INIT_FAILED;
+    }
+    #endif
+    telemetry->segment = segment;
+
+    if (RSI_LOAD_ACQUIRE(&segment->magic) != RSI_TELEMETRY_MAGIC) {
+        telemetry_unmap(telemetry);
+        free(telemetry);
+        return RSI_ERROR_NOT_RUNNING;
+    }
+
+    if (segment->version != RSI_TELEMETRY_VERSION || segment->size != sizeof(RSI_TelemetrySegment)) {
+        telemetry_unmap(telemetry);
+        free(telemetry);
+        return RSI_ERROR_NOT_SUPPORTED;
+    }
+
+    *handle = telemetry;
+    return RSI_SUCCESS;
+}
+
+static void percentiles_of(const RSI_Histogram* histogram, double scale, RSI_Percentiles* out) {
+    RSI_Histogram snapshot;
+    rsi_histogram_snapshot(histogram, &snapshot);
+    rsi_histogram_percentiles(&snapshot, NULL, scale, out);
+}
+
+RSI_Error RSI_TelemetryRead(RSI_TelemetryHandle telemetry, RSI_TelemetrySnapshot* snapshot) {
+    if (!telemetry || !snapshot) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+
+    const RSI_TelemetrySegment* segment = telemetry->segment;
+    if (RSI_LOAD_ACQUIRE(&segment->magic) != RSI_TELEMETRY_MAGIC) {
+        return RSI_ERROR_NOT_RUNNING;
+    }
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    uint64_t response_sum_ns = 0;
+
+    // The writer is in another process that may die mid-update
+    int tries = 0;
+    for (;; tries++) {
+        if (tries == TELEMETRY_READ_TRIES) {
+            return RSI_ERROR_TIMEOUT;
+        }
+
+        uint32_t sequence = RSI_LOAD_ACQUIRE(&segment->sequence);
+        if (sequence & 1) {
+            continue;
+        }
+
+        memcpy(&snapshot->frame, &segment->frame, sizeof(RSI_Frame));
+        response_sum_ns = segment->response_time_sum_ns;
+
+        RSI_FENCE_ACQUIRE();
+        if (RSI_LOAD_RELAXED(&segment->sequence) == sequence) {
+            break;
+        }
+    }
+
+    percentiles_of(&segment->response_histogram, 1e-6, &snapshot->response_times);
+    percentiles_of(&segment->jitter_histogram, 1e-6, &snapshot->jitter);
+
+    RSI_Statistics* stats = &snapshot->frame.stats;
+    if (stats->packets_received > 0) {
+        stats->avg_response_time_ms =
+            (double)response_sum_ns / 1000000.0 / (double)stats->packets_received;
+    }
+    stats->p50_response_time_ms = snapshot->response_times.p50_ms;
+    stats->p99_response_time_ms = snapshot->response_times.p99_ms;
+    stats->p999_response_time_ms = snapshot->response_times.p999_ms;
+    stats->p50_jitter_ms = snapshot->jitter.p50_ms;
+    stats->p99_jitter_ms = snapshot->jitter.p99_ms;
+    stats->p999_jitter_ms = snapshot->jitter.p999_ms;
+
+    snapshot->stage_timing = segment->stage_timing;
+    if (segment->stage_timing) {
+        for (int stage = 0; stage < RSI_STAGE_COUNT; stage++) {
+            percentiles_of(&segment->stage_histograms[stage], segment->tick_ns * 1e-6,
+                           &snapshot->stages[stage]);
+        }
+    }
+
+    snapshot->owner_pid = segment->owner_pid;
+    return RSI_SUCCESS;
+}
+
+RSI_Error RSI_TelemetryClose(RSI_TelemetryHandle telemetry) {
+    if (!telemetry || telemetry->writer) {
+        return RSI_ERROR_INVALID_PARAM;
+    }
+
+    rsi_telemetry_destroy(telemetry);
+    return RSI_SUCCESS;
+}
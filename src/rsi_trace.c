@@ -0,0 +1,108 @@
+/**
+ * @file rsi_trace.c
+ * @brief Always-on binary event trace of the network thread
+ *
+ * A fixed ring of records that the single writer overwrites oldest first,
+ * like a flight recorder. Writing a record is a handful of plain stores and
+ * no system call. Every slot carries its own sequence number, so readers on
+ * other threads copy records without stopping the writer and discard the
+ * ones it overwrote in the meantime. Timestamps are raw clock ticks and are
+ * converted to nanoseconds when read.
+ */
+
+#include "internal.h"
+
+#include <string.h>
+
+bool rsi_trace_init(RSI_Trace* trace, size_t capacity, uint64_t now_ns) {
+    size_t rounded = 1;
+
+    memset(trace, 0, sizeof(*trace));
+    if (capacity == 0) {
+        return false;
+    }
+
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    trace->slots = rsi_aligned_zalloc(rounded * sizeof(RSI_TraceSlot));
+    if (!trace->slots) {
+        return false;
+    }
+
+    trace->mask = rounded - 1;
+    trace->tick_ns = rsi_clock_tick_ns();
+    trace->base_ticks = rsi_clock_ticks();
+    trace->base_ns = now_ns;
+    return true;
+}
+
+void rsi_trace_free(RSI_Trace* trace) {
+    if (trace->slots) {
+        rsi_aligned_free(trace->slots);
+    }
+    memset(trace, 0, sizeof(*trace));
+}
+
+void rsi_trace_write(RSI_Trace* trace, uint64_t ticks, uint32_t event, uint32_t ipoc,
+                     uint64_t arg0, uint64_t arg1) {
+    uint64_t head = trace->head;
+    RSI_TraceSlot* slot = &trace->slots[head & trace->mask];
+
+    // Invalidate the slot before overwriting it (seqlock, 0 while writing)
+    RSI_STORE_RELAXED(&slot->sequence, 0);
+    RSI_FENCE_RELEASE();
+
+    slot->ticks = ticks;
+    slot->event = event;
+    slot->ipoc = ipoc;
+    slot->args[0] = arg0;
+    slot->args[1] = arg1;
+
+    RSI_STORE_RELEASE(&slot->sequence, head + 1);
+    RSI_STORE_RELEASE(&trace->head, head + 1);
+}
+
+uint64_t rsi_trace_position(const RSI_Trace* trace) {
+    return RSI_LOAD_ACQUIRE(&trace->head);
+}
+
+size_t rsi_trace_read(const RSI_Trace* trace, uint64_t* position, RSI_TraceRecord* out,
+                      size_t max_count, uint64_t* lost) {
+    uint64_t head = RSI_LOAD_ACQUIRE(&trace->head);
+    uint64_t next = *position;
+    size_t count = 0;
+
+    // Records older than one ring are gone
+    if (head - next > trace->mask + 1) {
+        *lost += head - (trace->mask + 1) - next;
+        next = head - (trace->mask + 1);
+    }
+
+    for (; next < head && count < max_count; next++) {
+        const RSI_TraceSlot* slot = &trace->slots[next & trace->mask];
+        RSI_TraceSlot copy;
+
+        uint64_t sequence = RSI_LOAD_ACQUIRE(&slot->sequence);
+        memcpy(&copy, slot, sizeof(copy));
+        RSI_FENCE_ACQUIRE();
+
+        // Overwritten since head was read, or being overwritten right now
+        if (sequence != next + 1 || RSI_LOAD_RELAXED(&slot->sequence) != sequence) {
+            (*lost)++;
+            continue;
+        }
+
+        RSI_TraceRecord* record = &out[count++];
+        int64_t elapsed = (int64_t)(copy.ticks - trace->base_ticks);
+        record->timestamp_ns = trace->base_ns + (uint64_t)(int64_t)((double)elapsed * trace->tick_ns);
+        record->event = copy.event;
+        record->ipoc = copy.ipoc;
+        record->args[0] = copy.args[0];
+        record->args[1] = copy.args[1];
+    }
+
+    *position = next;
+    return count;
+}